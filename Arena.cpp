@@ -0,0 +1,112 @@
+
+//----------------------------------------------------------------
+
+#include "Arena.h"
+
+//----------------------------------------------------------------
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Create an empty arena
+	//
+	// Inputs:
+	//		- size_t blockSize: the size of the blocks taken from the system
+	//
+	// Outputs:
+	//
+	Arena::Arena(size_t blockSize)
+		: current{ nullptr }, left{ 0 }, blockSize{ blockSize }, reserved{ 0 } {}
+
+//----------------------------------------------------------------
+
+	// Release all the blocks
+	Arena::~Arena() {
+		release();
+	}
+
+//----------------------------------------------------------------
+
+	// Get memory from the last block or from a new one if it does not fit
+	//
+	// Inputs:
+	//		- size_t size: the number of bytes
+	//		- size_t alignment: the alignment of the bytes (a power of 2)
+	//
+	// Outputs:
+	//		- void*: the memory
+	//
+	void* Arena::allocate(size_t size, size_t alignment) {
+
+		size_t padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+
+		if (!current || padding + size > left) {
+
+			// Requests larger than a block get a block of their own
+			size_t newBlockSize = std::max(blockSize, size + alignment);
+			char* block = static_cast<char*>(::operator new(newBlockSize));
+			blocks.push_back(block);
+			reserved += newBlockSize;
+
+			current = block;
+			left = newBlockSize;
+			padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+		}
+
+		void* memory = current + padding;
+		current += padding + size;
+		left -= padding + size;
+		return memory;
+
+	} // of function allocate
+
+//----------------------------------------------------------------
+
+	// Copy the characters of a word to the arena
+	//
+	// Inputs:
+	//		- std::string_view word: the word to copy
+	//
+	// Outputs:
+	//		- std::string_view: the copy that lives as long as the arena
+	//
+	std::string_view Arena::store(std::string_view word) {
+
+		char* memory = static_cast<char*>(allocate(word.length(), 1));
+		std::memcpy(memory, word.data(), word.length());
+		return { memory, word.length() };
+
+	} // of function store
+
+//----------------------------------------------------------------
+
+	// Release all the blocks at once
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void Arena::release() {
+
+		for (char* block : blocks)
+			::operator delete(block);
+		blocks.clear();
+
+		current = nullptr;
+		left = 0;
+		reserved = 0;
+
+	} // of function release
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,76 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <new>
+#include <string>
+#include <vector>
+#include <utility>
+#include <string_view>
+#include <type_traits>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// A bump allocator for the objects of a single query
+	//
+	// Memory is taken from the system in large blocks and handed out in order,
+	// so nodes created one after the other sit next to each other. Nothing is
+	// freed one by one: all the blocks are released together when the query ends
+	//
+	class Arena {
+	public:
+
+		// Create an empty arena that allocates blocks of 'blockSize' bytes
+		Arena(size_t blockSize = 64 * 1024);
+
+		// Release all the blocks
+		~Arena();
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		// Get 'size' bytes aligned to 'alignment'
+		void* allocate(size_t size, size_t alignment);
+
+		// Construct an object in the arena (it is never destroyed so it must not need to be)
+		template<typename T, typename... Args>
+		T* make(Args&&... args) {
+			static_assert(std::is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+			return new (allocate(sizeof(T), alignof(T))) T{ std::forward<Args>(args)... };
+		}
+
+		// Copy the characters of 'word' to the arena
+		std::string_view store(std::string_view word);
+
+		// Get the number of bytes taken from the system
+		size_t bytes_reserved() const { return reserved; }
+
+		// Release all the blocks at once
+		void release();
+
+	private:
+
+		std::vector<char*> blocks;
+		char* current;		// The next free byte of the last block
+		size_t left;		// The free bytes of the last block
+		size_t blockSize;
+		size_t reserved;
+
+	}; // of class Arena
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
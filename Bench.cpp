@@ -0,0 +1,379 @@
+
+//----------------------------------------------------------------
+
+#include "Bench.h"
+
+//----------------------------------------------------------------
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <tuple>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif // _WIN32
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The times every case is measured
+	static constexpr size_t benchPasses = 3;
+
+//----------------------------------------------------------------
+
+	// Check the words of one case and measure them
+	//
+	// Inputs:
+	//		- const ContextFreeGrammar& grammar: the grammar with the engine of the case
+	//		- const std::vector<std::string>& words: the words of the case
+	//		- BenchResult& result: where the measurements are stored
+	//
+	// Outputs:
+	//
+	static void measure_case(const ContextFreeGrammar& grammar, const std::vector<std::string>& words,
+		BenchResult& result) {
+
+		using namespace std::chrono;
+
+		result.words = words.size();
+		result.nodesExpanded = 0;
+		result.nodesGenerated = 0;
+		result.peakBytes = 0;
+
+		// The counters are the same in every pass and the fastest pass is kept
+		// because the slower ones only add the noise of the machine
+		QueryStats stats;
+		for (size_t pass = 0; pass < benchPasses; ++pass) {
+
+			auto time = steady_clock::now();
+			for (const std::string& word : words) {
+				grammar.query(word, &stats);
+				if (pass) continue;
+				result.nodesExpanded += stats.nodesExpanded;
+				result.nodesGenerated += stats.nodesGenerated;
+				result.peakBytes = std::max(result.peakBytes, stats.bytes);
+			}
+			double seconds = duration<double>(steady_clock::now() - time).count();
+			result.seconds = pass ? std::min(result.seconds, seconds) : seconds;
+		}
+
+	} // of function measure_case
+
+//----------------------------------------------------------------
+
+	// Run the benchmarks of every grammar in the folder
+	//
+	// For every length 1, 2, 3, 4, 6, 9, ... up to the longest one, the same accepted and
+	// rejected words are checked by every engine the grammar can use. The tree
+	// searches only get the words up to 'maxTreeLength' because their time grows
+	// exponentially with the length
+	//
+	// Inputs:
+	//		- const BenchOptions& options: what to run
+	//		- std::ostream& log: where the progress is printed
+	//
+	// Outputs:
+	//		- std::vector<BenchResult>: the measurements of every case
+	//
+	std::vector<BenchResult> run_benchmarks(const BenchOptions& options, std::ostream& log) {
+
+		using Engine = ContextFreeGrammar::Engine;
+		std::vector<BenchResult> results;
+
+		std::vector<std::string> files;
+		for (const auto& entry : std::filesystem::directory_iterator(options.folder))
+			if (entry.is_regular_file())
+				files.push_back(entry.path().generic_string());
+		std::sort(files.begin(), files.end());
+
+		for (const std::string& file : files) {
+
+			// The files that are not grammars are skipped
+			std::optional<ContextFreeGrammar> loaded;
+			try {
+				loaded.emplace(file);
+			}
+			catch (const Errors& e) {
+				log << "Skipping " << e.what() << '\n';
+				continue;
+			}
+			ContextFreeGrammar& grammar = *loaded;
+
+			// The engines this grammar can use
+			std::vector<std::tuple<Engine, Expansion, Ordering>> engines{
+				{ Engine::treeSearch, Expansion::allNonTerminals, Ordering::greedy },
+				{ Engine::treeSearch, Expansion::leftmost, Ordering::greedy },
+				{ Engine::treeSearch, Expansion::allNonTerminals, Ordering::aStar },
+				{ Engine::treeSearch, Expansion::leftmost, Ordering::aStar },
+				{ Engine::treeSearch, Expansion::allNonTerminals, Ordering::iterativeDeepening },
+				{ Engine::treeSearch, Expansion::leftmost, Ordering::iterativeDeepening },
+				{ Engine::cyk, Expansion::allNonTerminals, Ordering::greedy },
+				{ Engine::earley, Expansion::allNonTerminals, Ordering::greedy } };
+			if (grammar.set_engine(Engine::table))
+				engines.push_back({ Engine::table, Expansion::allNonTerminals, Ordering::greedy });
+
+			// The iterative deepening gets a small transposition table (without
+			// one it searches the same words again and again on rejected words)
+			grammar.set_transposition_bytes(1 << 20);
+
+			// One sampler for the words of every length
+			WordSampler wordSampler = grammar.sampler(options.maxLength);
+
+			for (size_t length = 1; length <= options.maxLength; length = std::max(length + 1, length * 3 / 2)) {
+
+				// The same words for every engine
+				uint64_t seed = options.seed * 1000003 + length;
+				std::vector<std::string> accepted = grammar.generate_words(wordSampler, length, options.wordsPerCase, seed);
+				std::vector<std::string> rejected = grammar.generate_words(wordSampler, length, options.wordsPerCase, seed, true);
+
+				for (const auto& [engine, expansion, ordering] : engines) {
+
+					if (engine == Engine::treeSearch && length > options.maxTreeLength) continue;
+
+					grammar.set_engine(engine);
+					grammar.set_expansion(expansion);
+					grammar.set_ordering(ordering);
+					for (bool isAccepted : { true, false }) {
+
+						const std::vector<std::string>& words = isAccepted ? accepted : rejected;
+						if (words.empty()) continue;
+
+						BenchResult result{ file, grammar.engine_name(), length, isAccepted };
+						measure_case(grammar, words, result);
+						results.push_back(result);
+
+						log << file << ' ' << result.engine << " length " << length
+							<< (isAccepted ? " accepted: " : " rejected: ")
+							<< result.seconds * 1e3 << " ms, " << result.nodesExpanded << " nodes\n";
+					}
+				}
+			}
+		}
+
+		return results;
+
+	} // of function run_benchmarks
+
+//----------------------------------------------------------------
+
+	// Write a string as a JSON string
+	static void write_json_string(std::ostream& out, const std::string& text) {
+
+		out << '"';
+		for (char ch : text) {
+			if (ch == '"' || ch == '\\') out << '\\';
+			out << ch;
+		}
+		out << '"';
+
+	} // of function write_json_string
+
+//----------------------------------------------------------------
+
+	// Write the results as JSON
+	//
+	// Inputs:
+	//		- std::ostream& out: where the JSON is written
+	//		- const std::vector<BenchResult>& results: the measurements
+	//
+	// Outputs:
+	//
+	void write_results(std::ostream& out, const std::vector<BenchResult>& results) {
+
+		out << "{\n  \"peakMemoryBytes\": " << peak_memory() << ",\n  \"results\": [\n";
+		out << std::setprecision(9);
+
+		for (size_t i = 0; i < results.size(); ++i) {
+
+			const BenchResult& result = results[i];
+			out << "    {\"grammar\": ";
+			write_json_string(out, result.grammar);
+			out << ", \"engine\": ";
+			write_json_string(out, result.engine);
+			out << ", \"length\": " << result.length
+				<< ", \"accepted\": " << (result.accepted ? "true" : "false")
+				<< ", \"words\": " << result.words
+				<< ", \"seconds\": " << result.seconds
+				<< ", \"wordsPerSecond\": " << (result.seconds > 0 ? result.words / result.seconds : 0)
+				<< ", \"nodesExpanded\": " << result.nodesExpanded
+				<< ", \"nodesGenerated\": " << result.nodesGenerated
+				<< ", \"peakBytes\": " << result.peakBytes << '}'
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+
+		out << "  ]\n}\n";
+
+	} // of function write_results
+
+//----------------------------------------------------------------
+
+	// Find the value of a key in a line that write_results wrote
+	//
+	// Inputs:
+	//		- const std::string& line: the line of a case
+	//		- const std::string& key: the key
+	//
+	// Outputs:
+	//		- std::string: the value (without the quotes of the strings)
+	//
+	static std::string json_field(const std::string& line, const std::string& key) {
+
+		size_t at = line.find("\"" + key + "\": ");
+		if (at == std::string::npos) return "";
+		at += key.length() + 4;
+		if (at >= line.length()) return "";
+
+		std::string value;
+		if (line[at] == '"') {
+			for (size_t i = at + 1; i < line.length() && line[i] != '"'; ++i) {
+				if (line[i] == '\\') ++i;
+				value += line[i];
+			}
+		}
+		else
+			for (size_t i = at; i < line.length() && line[i] != ',' && line[i] != '}'; ++i)
+				value += line[i];
+
+		return value;
+
+	} // of function json_field
+
+//----------------------------------------------------------------
+
+	// Read the results that write_results wrote
+	//
+	// Inputs:
+	//		- const std::string& filename: the JSON file
+	//
+	// Outputs:
+	//		- std::vector<BenchResult>: the measurements in the file
+	//
+	std::vector<BenchResult> read_results(const std::string& filename) {
+
+		std::ifstream fin{ filename };
+		if (!fin) throw Errors(filename, 0, Errors::ErrorType::fileNotFound);
+
+		std::vector<BenchResult> results;
+		std::string line;
+		while (std::getline(fin, line)) {
+
+			if (line.find("\"grammar\": ") == std::string::npos) continue;
+
+			BenchResult result;
+			result.grammar = json_field(line, "grammar");
+			result.engine = json_field(line, "engine");
+			result.length = std::stoull(json_field(line, "length"));
+			result.accepted = json_field(line, "accepted") == "true";
+			result.words = std::stoull(json_field(line, "words"));
+			result.seconds = std::stod(json_field(line, "seconds"));
+			result.nodesExpanded = std::stoull(json_field(line, "nodesExpanded"));
+			result.nodesGenerated = std::stoull(json_field(line, "nodesGenerated"));
+			result.peakBytes = std::stoull(json_field(line, "peakBytes"));
+			results.push_back(result);
+		}
+
+		return results;
+
+	} // of function read_results
+
+//----------------------------------------------------------------
+
+	// Compare the results with a baseline
+	//
+	// A case regresses if its time per word or its expanded nodes grew by more
+	// than 'threshold'. The times below 1 ms are too noisy and are not compared
+	//
+	// Inputs:
+	//		- const std::vector<BenchResult>& baseline: the results of the old build
+	//		- const std::vector<BenchResult>& results: the results of the new build
+	//		- double threshold: the growth that is allowed (0.1 for 10%)
+	//		- std::ostream& report: where the regressions are printed
+	//
+	// Outputs:
+	//		- size_t: the number of cases that regressed
+	//
+	size_t compare_results(const std::vector<BenchResult>& baseline,
+		const std::vector<BenchResult>& results, double threshold, std::ostream& report) {
+
+		auto keyOf = [](const BenchResult& result) {
+			return result.grammar + '|' + result.engine + '|' + std::to_string(result.length)
+				+ (result.accepted ? "|accepted" : "|rejected");
+		};
+
+		std::unordered_map<std::string, const BenchResult*> old;
+		for (const BenchResult& result : baseline)
+			old[keyOf(result)] = &result;
+
+		size_t nCompared = 0;
+		size_t nRegressions = 0;
+		for (const BenchResult& result : results) {
+
+			auto found = old.find(keyOf(result));
+			if (found == old.end() || !result.words || !found->second->words) continue;
+			++nCompared;
+
+			const BenchResult& before = *found->second;
+			double oldTime = before.seconds / before.words;
+			double newTime = result.seconds / result.words;
+			bool slower = before.seconds > 1e-3 && newTime > oldTime * (1 + threshold);
+			bool moreNodes = result.nodesExpanded > before.nodesExpanded * (1 + threshold);
+
+			if (slower || moreNodes) {
+				++nRegressions;
+				report << "Regression: " << keyOf(result) << ": "
+					<< oldTime * 1e3 << " -> " << newTime * 1e3 << " ms per word, "
+					<< before.nodesExpanded << " -> " << result.nodesExpanded << " nodes\n";
+			}
+		}
+
+		report << nCompared << " cases compared, " << nRegressions << " regressions\n";
+		return nRegressions;
+
+	} // of function compare_results
+
+//----------------------------------------------------------------
+
+	// Get the most memory the process has used
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- size_t: the peak resident memory in bytes
+	//
+	size_t peak_memory() {
+
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return counters.PeakWorkingSetSize;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage)) return 0;
+#ifdef __APPLE__
+		return static_cast<size_t>(usage.ru_maxrss);
+#else
+		return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif // __APPLE__
+#endif // _WIN32
+
+	} // of function peak_memory
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
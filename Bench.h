@@ -0,0 +1,76 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include <random>
+#include <ostream>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "ConFreeGr.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// What the benchmarks run
+	struct BenchOptions {
+
+		std::string folder = "grammars";	// Every grammar in the folder is measured
+		size_t maxLength = 64;				// The words have the lengths 1, 2, 3, 4, 6, 9, ... up to maxLength
+		size_t maxTreeLength = 13;			// The longest words that the tree searches get
+		size_t wordsPerCase = 20;			// The accepted and the rejected words of every length
+		uint64_t seed = 1;					// The same seed gives the same words
+
+	}; // of struct BenchOptions
+
+//----------------------------------------------------------------
+
+	// The measurements of one grammar, engine, length and result
+	struct BenchResult {
+
+		std::string grammar;
+		std::string engine;
+		size_t length;
+		bool accepted;			// If the words of the case are accepted or rejected
+
+		size_t words = 0;			// The number of words that were checked
+		double seconds = 0;			// The time all the words took
+		size_t nodesExpanded = 0;	// The nodes that the tree search expanded for all the words
+		size_t nodesGenerated = 0;
+		size_t peakBytes = 0;		// The memory of the biggest search tree of the case
+
+	}; // of struct BenchResult
+
+//----------------------------------------------------------------
+
+	// Run the benchmarks of every grammar and engine
+	std::vector<BenchResult> run_benchmarks(const BenchOptions& options, std::ostream& log);
+
+	// Write the results as JSON (one case per line so they are easy to compare)
+	void write_results(std::ostream& out, const std::vector<BenchResult>& results);
+
+	// Read the results that write_results wrote
+	std::vector<BenchResult> read_results(const std::string& filename);
+
+	// Print the cases that got slower or expanded more nodes than the baseline
+	// by more than 'threshold' (0.1 for 10%) and return their number
+	size_t compare_results(const std::vector<BenchResult>& baseline,
+		const std::vector<BenchResult>& results, double threshold, std::ostream& report);
+
+	// Get the most memory the process has used in bytes
+	size_t peak_memory();
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
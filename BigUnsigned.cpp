@@ -0,0 +1,171 @@
+
+//----------------------------------------------------------------
+
+#include "BigUnsigned.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Construct from a machine integer
+	//
+	// Inputs:
+	//		- uint64_t value: the value of the number
+	//
+	// Outputs:
+	//
+	BigUnsigned::BigUnsigned(uint64_t value) {
+
+		while (value) {
+			limbs.push_back(static_cast<uint32_t>(value));
+			value >>= 32;
+		}
+
+	} // of constructor BigUnsigned
+
+//----------------------------------------------------------------
+
+	// Add another number to 'this' one
+	//
+	// Inputs:
+	//		- const BigUnsigned& other: the number to add
+	//
+	// Outputs:
+	//		- BigUnsigned&: 'this' number
+	//
+	BigUnsigned& BigUnsigned::operator+=(const BigUnsigned& other) {
+
+		if (limbs.size() < other.limbs.size())
+			limbs.resize(other.limbs.size(), 0);
+
+		uint64_t carry = 0;
+		for (size_t i = 0; i < limbs.size() && (carry || i < other.limbs.size()); ++i) {
+			uint64_t sum = carry + limbs[i] + (i < other.limbs.size() ? other.limbs[i] : 0);
+			limbs[i] = static_cast<uint32_t>(sum);
+			carry = sum >> 32;
+		}
+		if (carry)
+			limbs.push_back(static_cast<uint32_t>(carry));
+
+		return *this;
+
+	} // of function operator+=
+
+//----------------------------------------------------------------
+
+	// Multiply two numbers (schoolbook, the counts only have a few limbs)
+	//
+	// Inputs:
+	//		- const BigUnsigned& a: the first factor
+	//		- const BigUnsigned& b: the second factor
+	//
+	// Outputs:
+	//		- BigUnsigned: the product
+	//
+	BigUnsigned operator*(const BigUnsigned& a, const BigUnsigned& b) {
+
+		BigUnsigned product;
+		if (a.is_zero() || b.is_zero()) return product;
+
+		product.limbs.assign(a.limbs.size() + b.limbs.size(), 0);
+		for (size_t i = 0; i < a.limbs.size(); ++i) {
+			uint64_t carry = 0;
+			for (size_t j = 0; j < b.limbs.size(); ++j) {
+				uint64_t sum = static_cast<uint64_t>(a.limbs[i]) * b.limbs[j] + product.limbs[i + j] + carry;
+				product.limbs[i + j] = static_cast<uint32_t>(sum);
+				carry = sum >> 32;
+			}
+			product.limbs[i + b.limbs.size()] = static_cast<uint32_t>(carry);
+		}
+		while (!product.limbs.empty() && product.limbs.back() == 0)
+			product.limbs.pop_back();
+
+		return product;
+
+	} // of function operator*
+
+//----------------------------------------------------------------
+
+	// Compare two numbers
+	//
+	// Inputs:
+	//		- const BigUnsigned& other: the number to compare with
+	//
+	// Outputs:
+	//		- std::strong_ordering: how 'this' number compares to 'other'
+	//
+	std::strong_ordering BigUnsigned::operator<=>(const BigUnsigned& other) const {
+
+		if (limbs.size() != other.limbs.size())
+			return limbs.size() <=> other.limbs.size();
+		for (size_t i = limbs.size(); i-- > 0;)
+			if (limbs[i] != other.limbs[i])
+				return limbs[i] <=> other.limbs[i];
+		return std::strong_ordering::equal;
+
+	} // of function operator<=>
+
+//----------------------------------------------------------------
+
+	// Get the number in decimal
+	//
+	// The limbs are divided by 10^9 again and again and every remainder
+	// gives nine digits
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- std::string: the digits of the number
+	//
+	std::string BigUnsigned::to_string() const {
+
+		if (is_zero()) return "0";
+
+		std::vector<uint32_t> rest = limbs;
+		std::vector<uint32_t> groups;		// The groups of nine digits, the last one first
+		while (!rest.empty()) {
+			uint64_t remainder = 0;
+			for (size_t i = rest.size(); i-- > 0;) {
+				uint64_t current = (remainder << 32) | rest[i];
+				rest[i] = static_cast<uint32_t>(current / 1000000000);
+				remainder = current % 1000000000;
+			}
+			groups.push_back(static_cast<uint32_t>(remainder));
+			while (!rest.empty() && rest.back() == 0)
+				rest.pop_back();
+		}
+
+		std::string digits = std::to_string(groups.back());
+		for (size_t i = groups.size() - 1; i-- > 0;) {
+			std::string group = std::to_string(groups[i]);
+			digits.append(9 - group.length(), '0');
+			digits += group;
+		}
+		return digits;
+
+	} // of function to_string
+
+//----------------------------------------------------------------
+
+	// Print a number in decimal
+	//
+	// Inputs:
+	//		- std::ostream& out: where it is printed
+	//		- const BigUnsigned& number: the number
+	//
+	// Outputs:
+	//		- std::ostream&: the same stream
+	//
+	std::ostream& operator<<(std::ostream& out, const BigUnsigned& number) {
+
+		return out << number.to_string();
+
+	} // of function operator<<
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,67 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include <compare>
+#include <cstdint>
+#include <ostream>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// An unsigned integer with as many digits as it needs (for the numbers
+	// of derivations, which grow exponentially with the length of a word)
+	//
+	// The value is kept in 32 bit limbs, the least significant first, with
+	// no zero limbs at the end (zero has none)
+	//
+	class BigUnsigned {
+	public:
+
+		// Construct from a machine integer (zero by default)
+		BigUnsigned(uint64_t value = 0);
+
+		// Add another number to 'this' one
+		BigUnsigned& operator+=(const BigUnsigned& other);
+
+		// Multiply two numbers
+		friend BigUnsigned operator*(const BigUnsigned& a, const BigUnsigned& b);
+
+		// Compare two numbers
+		bool operator==(const BigUnsigned& other) const = default;
+		std::strong_ordering operator<=>(const BigUnsigned& other) const;
+
+		// Check if the number is zero
+		bool is_zero() const { return limbs.empty(); }
+
+		// Get the number in decimal
+		std::string to_string() const;
+
+	private:
+
+		std::vector<uint32_t> limbs;
+
+	}; // of class BigUnsigned
+
+//----------------------------------------------------------------
+
+	// Print a number in decimal
+	std::ostream& operator<<(std::ostream& out, const BigUnsigned& number);
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,214 @@
+
+//----------------------------------------------------------------
+
+#include "Binary.h"
+
+//----------------------------------------------------------------
+
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The byte order mark that the header stores
+	static constexpr uint32_t byteOrderMark = 0x01020304;
+
+//----------------------------------------------------------------
+
+	// Hash a block of bytes 8 at a time with the multiply and xor steps of FNV-1a
+	//
+	// Inputs:
+	//		- const unsigned char* data: the bytes
+	//		- size_t size: the number of bytes
+	//
+	// Outputs:
+	//		- uint64_t: the hash
+	//
+	static uint64_t checksum_of(const unsigned char* data, size_t size) {
+
+		uint64_t hash = 0xCBF29CE484222325ULL ^ size;
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8) {
+			uint64_t chunk;
+			std::memcpy(&chunk, data + i, 8);
+			hash = (hash ^ chunk) * 0x100000001B3ULL;
+			hash ^= hash >> 29;
+		}
+		for (; i < size; ++i)
+			hash = (hash ^ data[i]) * 0x100000001B3ULL;
+		return hash;
+
+	} // of function checksum_of
+
+//----------------------------------------------------------------
+
+	// Check if a file starts with the magic of the compiled grammars
+	//
+	// Inputs:
+	//		- const std::string& filename: the file
+	//
+	// Outputs:
+	//		- bool: if the file is a compiled grammar (of any version)
+	//
+	bool is_compiled_grammar(const std::string& filename) {
+
+		std::ifstream fin{ filename, std::ios::binary };
+		char magic[sizeof(compiledMagic)] = {};
+		fin.read(magic, sizeof(magic));
+		return fin && std::memcmp(magic, compiledMagic, sizeof(magic)) == 0;
+
+	} // of function is_compiled_grammar
+
+//----------------------------------------------------------------
+
+	// Write the header and the payload to a file
+	//
+	// Inputs:
+	//		- const std::string& filename: the file to write
+	//
+	// Outputs:
+	//
+	void BinaryWriter::save(const std::string& filename) const {
+
+		CompiledHeader header{};
+		std::memcpy(header.magic, compiledMagic, sizeof(compiledMagic));
+		header.version = compiledVersion;
+		header.byteOrder = byteOrderMark;
+		header.payloadSize = bytes.size();
+		header.checksum = checksum_of(bytes.data(), bytes.size());
+
+		std::ofstream fout{ filename, std::ios::binary | std::ios::trunc };
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fout.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+		if (!fout) throw std::runtime_error("Cannot write the compiled grammar " + filename);
+
+	} // of function save
+
+//----------------------------------------------------------------
+
+	// Map a whole file to memory for reading
+	//
+	// Inputs:
+	//		- const std::string& filename: the file to map
+	//
+	// Outputs:
+	//
+#ifdef _WIN32
+	MappedFile::MappedFile(const std::string& filename)
+		: begin{ nullptr }, length{ 0 }, file{ INVALID_HANDLE_VALUE }, mapping{ nullptr } {
+
+		file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw Errors(filename, 0, Errors::ErrorType::fileNotFound);
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || !size.QuadPart) {
+			CloseHandle(file);
+			throw Errors(filename, 0, Errors::ErrorType::compiledGrammarError);
+		}
+		length = static_cast<size_t>(size.QuadPart);
+
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping)
+			begin = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!begin) {
+			if (mapping) CloseHandle(mapping);
+			CloseHandle(file);
+			throw Errors(filename, 0, Errors::ErrorType::compiledGrammarError);
+		}
+	}
+
+	MappedFile::~MappedFile() {
+		UnmapViewOfFile(begin);
+		CloseHandle(mapping);
+		CloseHandle(file);
+	}
+#else
+	MappedFile::MappedFile(const std::string& filename) : begin{ nullptr }, length{ 0 } {
+
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd == -1)
+			throw Errors(filename, 0, Errors::ErrorType::fileNotFound);
+
+		struct stat info;
+		if (fstat(fd, &info) == -1 || info.st_size <= 0) {
+			close(fd);
+			throw Errors(filename, 0, Errors::ErrorType::compiledGrammarError);
+		}
+		length = static_cast<size_t>(info.st_size);
+
+		// The mapping stays valid after the file is closed
+		void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (address == MAP_FAILED)
+			throw Errors(filename, 0, Errors::ErrorType::compiledGrammarError);
+		begin = static_cast<const unsigned char*>(address);
+	}
+
+	MappedFile::~MappedFile() {
+		munmap(const_cast<unsigned char*>(begin), length);
+	}
+#endif // _WIN32
+
+//----------------------------------------------------------------
+
+	// Check the header and the checksum of a mapped compiled grammar
+	//
+	// Inputs:
+	//		- const MappedFile& file: the mapped file
+	//		- const std::string& filename: the name of the file for the errors
+	//
+	// Outputs:
+	//
+	BinaryReader::BinaryReader(const MappedFile& file, const std::string& filename)
+		: filename{ filename }, payload{ nullptr }, position{ nullptr }, end{ nullptr } {
+
+		if (file.size() < sizeof(CompiledHeader)) fail();
+
+		CompiledHeader header;
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (std::memcmp(header.magic, compiledMagic, sizeof(compiledMagic)) != 0
+			|| header.version != compiledVersion || header.byteOrder != byteOrderMark
+			|| header.payloadSize != file.size() - sizeof(CompiledHeader))
+			fail();
+
+		payload = file.data() + sizeof(CompiledHeader);
+		position = payload;
+		end = payload + header.payloadSize;
+
+		if (checksum_of(payload, header.payloadSize) != header.checksum) fail();
+	}
+
+//----------------------------------------------------------------
+
+	// Throw the error of a damaged or incompatible compiled grammar
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void BinaryReader::fail() const {
+		throw Errors(filename, 0, Errors::ErrorType::compiledGrammarError);
+	}
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,189 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "GramErr.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The first bytes of every compiled grammar
+	static constexpr char compiledMagic[8] = { 'C', 'F', 'G', 'B', 'I', 'N', '\x1a', '\n' };
+
+	// The version of the layout of the compiled grammars
+	// (a file of another version has to be compiled again)
+	static constexpr uint32_t compiledVersion = 2;
+
+	// The header of a compiled grammar, followed by 'payloadSize' bytes
+	struct CompiledHeader {
+
+		char magic[8];			// compiledMagic
+		uint32_t version;		// compiledVersion
+		uint32_t byteOrder;		// 0x01020304 as written by the machine that compiled the file
+		uint64_t payloadSize;	// The bytes after the header
+		uint64_t checksum;		// A hash of the payload
+
+	}; // of struct CompiledHeader
+
+	// Check if a file starts with the magic of the compiled grammars
+	bool is_compiled_grammar(const std::string& filename);
+
+//----------------------------------------------------------------
+
+	// Collects the tables of a grammar and writes them to a compiled file
+	//
+	// Every array is stored as its length followed by its elements, starting at
+	// a multiple of 8 bytes, so a reader can use the elements where they are in the file
+	//
+	class BinaryWriter {
+	public:
+
+		// Append a value
+		template <typename T>
+		void put(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			const unsigned char* first = reinterpret_cast<const unsigned char*>(&value);
+			bytes.insert(bytes.end(), first, first + sizeof(T));
+		}
+
+		// Append the length and the elements of an array
+		template <typename T>
+		void put_array(std::span<const T> values) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			align();
+			put<uint64_t>(values.size());
+			const unsigned char* first = reinterpret_cast<const unsigned char*>(values.data());
+			bytes.insert(bytes.end(), first, first + values.size_bytes());
+		}
+
+		template <typename T>
+		void put_array(const std::vector<T>& values) { put_array(std::span<const T>{ values }); }
+
+		// Append the length and the characters of a string
+		void put_string(std::string_view text) { put_array(std::span<const char>{ text.data(), text.size() }); }
+
+		// Write the header and the payload to a file (throws std::runtime_error if it fails)
+		void save(const std::string& filename) const;
+
+	private:
+
+		// Pad the payload to a multiple of 8 bytes (the header is 32 bytes long)
+		void align() { bytes.resize((bytes.size() + 7) / 8 * 8, 0); }
+
+		std::vector<unsigned char> bytes;
+
+	}; // of class BinaryWriter
+
+//----------------------------------------------------------------
+
+	// A file mapped to memory for reading
+	//
+	// The pages are only read from the disk when they are touched, so opening
+	// many compiled grammars costs a few page faults instead of a copy of them
+	//
+	class MappedFile {
+	public:
+
+		// Map a whole file (throws Errors if it cannot be opened)
+		MappedFile(const std::string& filename);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const unsigned char* data() const { return begin; }
+		size_t size() const { return length; }
+
+	private:
+
+		const unsigned char* begin;
+		size_t length;
+
+#ifdef _WIN32
+		void* file;
+		void* mapping;
+#endif // _WIN32
+
+	}; // of class MappedFile
+
+//----------------------------------------------------------------
+
+	// Reads the tables of a compiled grammar in place
+	//
+	// The header and the checksum are checked when the reader is created and
+	// every read is checked against the end of the payload, so a damaged file
+	// throws Errors instead of being read out of bounds
+	//
+	class BinaryReader {
+	public:
+
+		// Check the header and the checksum of a mapped compiled grammar
+		BinaryReader(const MappedFile& file, const std::string& filename);
+
+		// Read a value
+		template <typename T>
+		T get() {
+			static_assert(std::is_trivially_copyable_v<T>);
+			T value;
+			std::memcpy(&value, take(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		// Read an array without copying its elements
+		template <typename T>
+		std::span<const T> get_array() {
+			static_assert(std::is_trivially_copyable_v<T>);
+			take((8 - (position - payload) % 8) % 8);
+			uint64_t count = get<uint64_t>();
+			if (count > (end - position) / sizeof(T)) fail();
+			return { reinterpret_cast<const T*>(take(count * sizeof(T))), static_cast<size_t>(count) };
+		}
+
+		// Read a string without copying its characters
+		std::string_view get_string() {
+			std::span<const char> text = get_array<char>();
+			return { text.data(), text.size() };
+		}
+
+		// Throw Errors for a damaged file
+		[[noreturn]] void fail() const;
+
+	private:
+
+		// Move past 'n' bytes and get where they start
+		const unsigned char* take(size_t n) {
+			if (n > static_cast<size_t>(end - position)) fail();
+			const unsigned char* first = position;
+			position += n;
+			return first;
+		}
+
+		std::string filename;
+		const unsigned char* payload;
+		const unsigned char* position;
+		const unsigned char* end;
+
+	}; // of class BinaryReader
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
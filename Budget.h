@@ -0,0 +1,124 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The answer of a query that may stop early
+	enum class QueryResult {
+		rejected,		// The word cannot be generated
+		accepted,		// The word can be generated
+		limitExceeded	// The search stopped at a limit or was cancelled before it knew
+	};
+
+//----------------------------------------------------------------
+
+	// A flag that another thread sets to stop the queries that were given it
+	//
+	// The copies of a token share the flag. A default token cannot be
+	// cancelled and costs nothing to check
+	//
+	class CancellationToken {
+	public:
+
+		// A token that is never cancelled
+		CancellationToken() = default;
+
+		// A token that can be cancelled
+		static CancellationToken make() {
+			CancellationToken token;
+			token.flag = std::make_shared<std::atomic<bool>>(false);
+			return token;
+		}
+
+		// Stop every query that checks 'this' token or one of its copies
+		void cancel() const { if (flag) flag->store(true, std::memory_order_relaxed); }
+
+		// Check if the token was cancelled
+		bool cancelled() const { return flag && flag->load(std::memory_order_relaxed); }
+
+	private:
+
+		std::shared_ptr<std::atomic<bool>> flag;
+
+	}; // of class CancellationToken
+
+//----------------------------------------------------------------
+
+	// The limits of a query (zero for no limit)
+	//
+	// Only the tree search checks them, after every expansion, so a query can
+	// go over the nodes or the bytes by the children of one node. The other
+	// engines always finish in polynomial time
+	//
+	struct QueryOptions {
+
+		size_t maxExpanded = 0;		// The most nodes that are expanded
+		size_t maxBytes = 0;		// The most memory of the nodes, their words and the visited set
+
+		std::chrono::nanoseconds timeout{ 0 };		// The longest time from the start of the query
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+		CancellationToken cancellation;
+
+	}; // of struct QueryOptions
+
+//----------------------------------------------------------------
+
+	// The limits of one query as the search loop checks them
+	class QueryBudget {
+	public:
+
+		// Start the clock of a query (no limits if 'options' is nullptr)
+		explicit QueryBudget(const QueryOptions* options)
+			: options{ options }, deadline{ std::chrono::steady_clock::time_point::max() } {
+
+			if (!options) return;
+			deadline = options->deadline;
+			if (options->timeout.count() > 0)
+				deadline = std::min(deadline, std::chrono::steady_clock::now() + options->timeout);
+		}
+
+		// Check if a search that has expanded 'nExpanded' nodes and uses 'bytes' must stop
+		bool exceeded(size_t nExpanded, size_t bytes) const {
+
+			if (!options) return false;
+			if (options->maxExpanded && nExpanded >= options->maxExpanded) return true;
+			if (options->maxBytes && bytes > options->maxBytes) return true;
+			if (options->cancellation.cancelled()) return true;
+			return deadline != std::chrono::steady_clock::time_point::max()
+				&& std::chrono::steady_clock::now() >= deadline;
+		}
+
+		// Check if there is any limit
+		bool limited() const { return options; }
+
+	private:
+
+		const QueryOptions* options;
+		std::chrono::steady_clock::time_point deadline;
+
+	}; // of class QueryBudget
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,155 @@
+
+//----------------------------------------------------------------
+
+#include "Cache.h"
+
+//----------------------------------------------------------------
+
+#include <functional>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Create an empty cache
+	//
+	// Inputs:
+	//		- size_t maxBytes: the memory budget of the results
+	//		- bool keepDerivations: keep the derivations of the accepted words
+	//
+	// Outputs:
+	//
+	ResultCache::ResultCache(size_t maxBytes, bool keepDerivations)
+		: maxShardBytes{ maxBytes / nShards }, keepDerivations{ keepDerivations },
+		hits{ 0 }, misses{ 0 }, evictions{ 0 } {}
+
+//----------------------------------------------------------------
+
+	// Get the shard of a word by its hash
+	//
+	// Inputs:
+	//		- std::string_view word: the word
+	//
+	// Outputs:
+	//		- Shard&: the shard that holds the result of the word
+	//
+	ResultCache::Shard& ResultCache::shard_of(std::string_view word) {
+		return shards[std::hash<std::string_view>{}(word) % nShards];
+	}
+
+//----------------------------------------------------------------
+
+	// Find the result of a word and make it the most recently used
+	//
+	// Inputs:
+	//		- const std::string& word: the word
+	//		- bool needDerivation: the derivation of an accepted word is needed too
+	//		- bool& accepted: the result that was found
+	//		- std::vector<std::string>& derivation: the derivation that was found
+	//
+	// Outputs:
+	//		- bool true: the result was found
+	//		- bool false: the word needs to be checked
+	//
+	bool ResultCache::find(const std::string& word, bool needDerivation,
+		bool& accepted, std::vector<std::string>& derivation) {
+
+		Shard& shard = shard_of(word);
+		std::lock_guard<std::mutex> guard{ shard.lock };
+
+		auto found = shard.index.find(word);
+		if (found == shard.index.end()
+			|| (needDerivation && found->second->accepted && found->second->derivation.empty())) {
+			++misses;
+			return false;
+		}
+
+		shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+		accepted = found->second->accepted;
+		if (needDerivation)
+			derivation = found->second->derivation;
+		++hits;
+		return true;
+
+	} // of function find
+
+//----------------------------------------------------------------
+
+	// Store the result of a word as the most recently used and drop the least
+	// recently used results until the shard is in its budget again
+	//
+	// Inputs:
+	//		- const std::string& word: the word
+	//		- bool accepted: if the word was accepted
+	//		- const std::vector<std::string>& derivation: the derivation of the word
+	//			(it is only kept if the cache keeps derivations)
+	//
+	// Outputs:
+	//
+	void ResultCache::insert(const std::string& word, bool accepted,
+		const std::vector<std::string>& derivation) {
+
+		Entry entry{ word, accepted, {}, 0 };
+		if (keepDerivations)
+			entry.derivation = derivation;
+
+		// The list and the index nodes of the entry and the characters of the words
+		entry.bytes = sizeof(Entry) + 4 * sizeof(void*) + sizeof(std::string_view) + word.capacity();
+		for (const std::string& step : entry.derivation)
+			entry.bytes += sizeof(std::string) + step.capacity();
+
+		Shard& shard = shard_of(word);
+		std::lock_guard<std::mutex> guard{ shard.lock };
+
+		// Another thread may have stored the same word
+		auto found = shard.index.find(word);
+		if (found != shard.index.end()) {
+			shard.bytes -= found->second->bytes;
+			shard.entries.erase(found->second);
+			shard.index.erase(found);
+		}
+
+		if (entry.bytes > maxShardBytes) return;
+
+		shard.entries.push_front(std::move(entry));
+		shard.index.emplace(shard.entries.front().word, shard.entries.begin());
+		shard.bytes += shard.entries.front().bytes;
+
+		while (shard.bytes > maxShardBytes) {
+			Entry& oldest = shard.entries.back();
+			shard.bytes -= oldest.bytes;
+			shard.index.erase(oldest.word);
+			shard.entries.pop_back();
+			++evictions;
+		}
+
+	} // of function insert
+
+//----------------------------------------------------------------
+
+	// Get the counters of the cache
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- CacheStats: the hits, misses and evictions and the size of the cache
+	//
+	CacheStats ResultCache::stats() const {
+
+		CacheStats result{ hits.load(), misses.load(), evictions.load(), 0, 0 };
+		for (const Shard& shard : shards) {
+			std::lock_guard<std::mutex> guard{ shard.lock };
+			result.entries += shard.entries.size();
+			result.bytes += shard.bytes;
+		}
+		return result;
+
+	} // of function stats
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
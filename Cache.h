@@ -0,0 +1,104 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <list>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// How a result cache has been used
+	struct CacheStats {
+
+		size_t hits;		// The queries that found their result
+		size_t misses;		// The queries that had to check their word
+		size_t evictions;	// The results removed to stay in the memory budget
+		size_t entries;		// The results in the cache
+		size_t bytes;		// The memory the results use
+
+	}; // of struct CacheStats
+
+//----------------------------------------------------------------
+
+	// A bounded cache of the results of check_word that drops the least
+	// recently used results first
+	//
+	// The words are split to shards by their hash and every shard has its own
+	// lock, list of recent results and part of the memory budget, so threads
+	// that check different words rarely wait for each other
+	//
+	class ResultCache {
+	public:
+
+		// Create an empty cache that uses at most 'maxBytes' bytes
+		// and keeps the derivations if 'keepDerivations' is true
+		ResultCache(size_t maxBytes, bool keepDerivations);
+
+		// Find the result of a word (and its derivation if 'needDerivation' is true)
+		// A result that was stored without the derivation it needs counts as a miss
+		bool find(const std::string& word, bool needDerivation,
+			bool& accepted, std::vector<std::string>& derivation);
+
+		// Store the result of a word and drop old results to stay in the budget
+		void insert(const std::string& word, bool accepted,
+			const std::vector<std::string>& derivation);
+
+		// Get the counters of the cache
+		CacheStats stats() const;
+
+		// Check if the cache keeps the derivations
+		bool keeps_derivations() const { return keepDerivations; }
+
+	private:
+
+		static constexpr size_t nShards = 16;
+
+		struct Entry {
+			std::string word;
+			bool accepted;
+			std::vector<std::string> derivation;
+			size_t bytes;
+		};
+
+		struct Shard {
+			mutable std::mutex lock;
+			std::list<Entry> entries;	// The most recently used first
+			std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+			size_t bytes = 0;
+		};
+
+		// Get the shard of a word
+		Shard& shard_of(std::string_view word);
+
+		std::array<Shard, nShards> shards;
+		size_t maxShardBytes;
+		bool keepDerivations;
+
+		std::atomic<size_t> hits;
+		std::atomic<size_t> misses;
+		std::atomic<size_t> evictions;
+
+	}; // of class ResultCache
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
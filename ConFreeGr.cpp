@@ -23,6 +23,20 @@ namespace Grammars {
 		if (!fin) throw Errors(infile, 0, Errors::ErrorType::fileNotFound);
 
 		filename = infile;
+		engine = Engine::treeSearch;
+		expansion = Expansion::allNonTerminals;
+		ordering = Ordering::greedy;
+		transpositionBytes = 0;
+		nodeEncoding = NodeEncoding::words;
+		threads = 1;
+		visitedMode = VisitedSet::Mode::exact;
+		visitedBloomBits = 0;
+
+		// A compiled grammar already has its rules normalized and its tables built
+		if (is_compiled_grammar(infile)) {
+			load_compiled(infile);
+			return;
+		}
 
 		// Read number of terminal symbols
 		int nTermSymbols;
@@ -32,13 +46,12 @@ namespace Grammars {
 
 		char tempSymbol = ' ';
 		// Read the terminal symbols and check for duplicates
-		for (int i = 0; i < nTermSymbols; ++i)
-			if (!termSymbols.contains(fin.peek())) {
-				fin >> tempSymbol;
-				termSymbols.insert(tempSymbol);
-			}
-			else
+		for (int i = 0; i < nTermSymbols; ++i) {
+			fin >> tempSymbol;
+			if (symbols.kind(tempSymbol) != SymbolTable::Kind::none)
 				throw Errors(filename, 2, Errors::ErrorType::duplicateTermSymbol);
+			symbols.add_terminal(tempSymbol);
+		}
 
 
 		// Read number of non-terminal symbols
@@ -48,19 +61,18 @@ namespace Grammars {
 			throw Errors(filename, 3, Errors::ErrorType::nNonTermSymbolsError);
 
 		// Read the non-terminal symbols and check for duplicates
-		// both in nonTermSymbols vector and in termSymbols vector
-		for (int i = 0; i < nNonTermSymbols; ++i)
-			if (!nonTermSymbols.contains(fin.peek()) || !termSymbols.contains(fin.peek())) {
-				fin >> tempSymbol;
-				nonTermSymbols.insert(tempSymbol);
-			}
-			else
+		// both in the non-terminal and in the terminal symbols
+		for (int i = 0; i < nNonTermSymbols; ++i) {
+			fin >> tempSymbol;
+			if (symbols.kind(tempSymbol) != SymbolTable::Kind::none)
 				throw Errors(filename, 4, Errors::ErrorType::duplicateNonTermSymbol);
+			symbols.add_non_terminal(tempSymbol);
+		}
 
 
 		// Read the initial symbol and check if it is defined in the non-terminal symbols
 		fin >> initialSymbol;
-		if(fin.bad() || !nonTermSymbols.contains(initialSymbol))
+		if(fin.bad() || !symbols.is_non_terminal(initialSymbol))
 			throw Errors(filename, 5, Errors::ErrorType::initialSymbolError);
 
 
@@ -77,7 +89,7 @@ namespace Grammars {
 		for (int i = 0; i < nRules; ++i) {
 			
 			fin >> ruleInput;
-			if(!nonTermSymbols.contains(ruleInput))
+			if(!symbols.is_non_terminal(ruleInput))
 				throw Errors(filename, 7 + i, Errors::ErrorType::rulesError);
 			if (!isspace(fin.peek())) fin.setstate(std::fstream::badbit);
 			std::getline(fin, ruleOutput);
@@ -90,12 +102,13 @@ namespace Grammars {
 			if (ruleOutput == EMPTYSTRING) ruleOutput = "";
 
 			for(const char ch : ruleOutput)
-				if(!termSymbols.contains(ch) && !nonTermSymbols.contains(ch))
+				if(symbols.kind(ch) == SymbolTable::Kind::none)
 					throw Errors(filename, 7 + i, Errors::ErrorType::rulesError);
 
 			if (fin.bad() || std::find(ruleMap[ruleInput].begin(), ruleMap[ruleInput].end(),
 								ruleOutput) != ruleMap[ruleInput].end())
 				throw Errors(filename, 7 + i, Errors::ErrorType::rulesError);
+			grammarRules.push_back({ ruleInput, ruleOutput });
 
 			// Discard rules that won't make a difference
 			if (std::string{ ruleInput } == ruleOutput) continue;
@@ -105,7 +118,7 @@ namespace Grammars {
 			// Define the max length of the rule outputs
 			bool onlyNonTerms = true;
 			for (char ch : ruleOutput)
-				if (termSymbols.contains(ch)) {
+				if (symbols.is_terminal(ch)) {
 					onlyNonTerms = false;
 					break;
 				}
@@ -118,57 +131,22 @@ namespace Grammars {
 
 		}
 
-		// Delete all the rules with empty outputs and create new rules from the
-		// existing ones deleting the non-terminal symbol that outputs empty string
-		// Example:
-
-		// THIS IS A MESS (but it works (atleast for small inputs))
-		// IT NEEDS MANY IMPROVEMENTS
-		bool searchAgain = true;
-		while (searchAgain) {
-			searchAgain = false;
-			std::unordered_map<char, std::vector<std::string>> dummyRuleMap;
-			for (const auto& pairI : ruleMap) {
-				for (int i = 0; i < pairI.second.size(); ++i) {
-					if (!pairI.second[i].length()) {
-						searchAgain = true;
-						dummyRuleMap.clear();
-						dummyRuleMap[pairI.first].push_back(std::string{ pairI.first });
-						dummyRuleMap[pairI.first].push_back("");
-						{
-							std::vector<std::string> tempV = pairI.second;
-							tempV.erase(tempV.begin() + i);
-							ruleMap[pairI.first] = tempV;
-						}
-						for (const auto& pairJ : ruleMap) {
-							for (int j = 0; j < pairJ.second.size(); ++j)
-							{
-								int newOutputsSize = 0;
-								int lastRuleIndex = -1;
-								for (int k = 0; k < pairJ.second[j].length(); ++k)
-									if (pairJ.second[j][k] == pairI.first) {
-										if (!newOutputsSize)
-											newOutputsSize = 2;
-										else
-											newOutputsSize *= 2;
-										lastRuleIndex = k;
-									}
-								if (lastRuleIndex == -1) continue;
-								std::vector<std::string> newOutputs(newOutputsSize);
-								size_t vIndex = 0;
-								generate_words(pairJ.second[j], 0, dummyRuleMap, lastRuleIndex, newOutputs, vIndex);
-								std::vector<std::string> tempV = pairJ.second;
-								for (int k = 0; k < newOutputs.size(); ++k)
-									if (!newOutputs[k].empty() &&
-										std::find(tempV.begin(), tempV.end(), newOutputs[k]) == tempV.end())
-										tempV.push_back(newOutputs[k]);
-								ruleMap[pairJ.first] = tempV;
-							}
-						}
-					}
-				}
-			}
-		}
+		// Remove the empty and the unit rules and build the Chomsky Normal Form
+		// copy of the rules for the CYK engine
+		CnfGrammar cnf;
+		normalizationReport = normalize(filename, initialSymbol, symbols, ruleMap, acceptsEmpty, &cnf);
+		cykParser = CykParser{ cnf };
+
+		// Index the normalized rules by the id of their input symbol for the tree search
+		symbols.set_rules(ruleMap);
+
+		// Flatten the rules for the Earley engine
+		earleyParser = EarleyParser{ initialSymbol, ruleMap };
+
+		// Deterministic grammars are checked with an LL(1) or an LALR(1) table
+		tableParser = TableParser{ initialSymbol, symbols, ruleMap };
+		if (tableParser.get_kind() != TableParser::Kind::none)
+			engine = Engine::table;
 
 #ifdef SHOW_RULES
 		std::cout << filename << '\n';
@@ -181,11 +159,134 @@ namespace Grammars {
 		std::cout << '\n';
 #endif // SHOW_RULES
 
+#ifdef SHOW_NORMALIZATION
+		for (const NormalizationStep& step : normalizationReport)
+			std::cout << step.name << ": " << step.milliseconds << " ms, "
+				<< step.nNonTerms << " non-terminals, " << step.nRules << " rules, "
+				<< "size " << step.size << '\n';
+		std::cout << '\n';
+#endif // SHOW_NORMALIZATION
+
 	} // of constructor ContextFreeGrammar
 
+//----------------------------------------------------------------
+
+	// Write a compiled grammar
+	//
+	// The file holds the normalized rules with their yields and counts, the
+	// rules as they were written (for the parse forests), the masks of CYK, the flattened rules of Earley, the LL(1) or LALR(1) table
+	// and the normalization report, so loading it needs neither the text
+	// parser nor the normalization
+	//
+	// Inputs:
+	//		- const std::string& outfile: the file to write
+	//
+	// Outputs:
+	//
+	void ContextFreeGrammar::compile(const std::string& outfile) const {
+
+		BinaryWriter out;
+
+		out.put<char>(initialSymbol);
+		out.put<uint8_t>(acceptsEmpty);
+		out.put<uint64_t>(maxRuleGenLen);
+
+		out.put<uint64_t>(normalizationReport.size());
+		for (const NormalizationStep& step : normalizationReport) {
+			out.put_string(step.name);
+			out.put<double>(step.milliseconds);
+			out.put<uint64_t>(step.nNonTerms);
+			out.put<uint64_t>(step.nRules);
+			out.put<uint64_t>(step.size);
+		}
+
+		symbols.write(out);
+
+		std::string inputs;
+		std::vector<uint64_t> ends;
+		std::string outputs;
+		for (const auto& [input, output] : grammarRules) {
+			inputs += input;
+			outputs += output;
+			ends.push_back(outputs.size());
+		}
+		out.put_string(inputs);
+		out.put_array(ends);
+		out.put_string(outputs);
+
+		cykParser.write(out);
+		earleyParser.write(out);
+		tableParser.write(out);
+
+		out.save(outfile);
+
+	} // of function compile
+
+//----------------------------------------------------------------
+
+	// Load the tables of a file written by 'compile'
+	//
+	// The file is mapped to memory and the arrays are read where they are
+	//
+	// Inputs:
+	//		- const std::string& infile: the compiled grammar
+	//
+	// Outputs:
+	//
+	void ContextFreeGrammar::load_compiled(const std::string& infile) {
+
+		MappedFile file{ infile };
+		BinaryReader in{ file, infile };
+
+		initialSymbol = in.get<char>();
+		acceptsEmpty = in.get<uint8_t>();
+		maxRuleGenLen = in.get<uint64_t>();
+
+		size_t nSteps = in.get<uint64_t>();
+		for (size_t i = 0; i < nSteps; ++i) {
+			NormalizationStep step;
+			step.name = in.get_string();
+			step.milliseconds = in.get<double>();
+			step.nNonTerms = in.get<uint64_t>();
+			step.nRules = in.get<uint64_t>();
+			step.size = in.get<uint64_t>();
+			normalizationReport.push_back(step);
+		}
+
+		symbols = SymbolTable{ in };
+		if (!symbols.is_non_terminal(initialSymbol)) in.fail();
+
+		std::string_view inputs = in.get_string();
+		std::span<const uint64_t> ends = in.get_array<uint64_t>();
+		std::string_view outputs = in.get_string();
+		if (ends.size() != inputs.size()) in.fail();
+		for (size_t r = 0, begin = 0; r < inputs.size(); begin = ends[r++]) {
+			if (ends[r] < begin || ends[r] > outputs.size() || !symbols.is_non_terminal(inputs[r])) in.fail();
+			std::string_view output = outputs.substr(begin, ends[r] - begin);
+			for (char ch : output)
+				if (symbols.kind(ch) == SymbolTable::Kind::none) in.fail();
+			grammarRules.push_back({ inputs[r], std::string{ output } });
+		}
+		cykParser = CykParser{ in };
+		earleyParser = EarleyParser{ in };
+		tableParser = TableParser{ in };
+
+		// The rules by their input symbol as the text parser leaves them
+		for (size_t i = 0; i < symbols.n_non_terminals(); ++i) {
+			char nonTerm = symbols.non_terminal(i);
+			if (!symbols.rules_of(nonTerm).empty())
+				ruleMap[nonTerm] = symbols.rules_of(nonTerm);
+		}
+
+		if (tableParser.get_kind() != TableParser::Kind::none)
+			engine = Engine::table;
+
+	} // of function load_compiled
+
 //----------------------------------------------------------------
 
 	// Check if a word can be generated from 'this' grammar
+	// and print the derivation the tree search finds
 	//
 	// Inputs:
 	//		- std::string word: the given word
@@ -195,116 +296,599 @@ namespace Grammars {
 	//		- bool false: 'word' was NOT accepted
 	//
 	bool ContextFreeGrammar::check_word(std::string word) const {
+		return check(word, threads, true) == QueryResult::accepted;
+	}
+
+//----------------------------------------------------------------
+
+	// Check if a word can be generated from 'this' grammar without printing anything
+	//
+	// Inputs:
+	//		- const std::string& word: the given word
+	//		- QueryStats* stats: where to store what the query did (nullptr if not needed)
+	//
+	// Outputs:
+	//		- bool true: 'word' was accepted
+	//		- bool false: 'word' was NOT accepted
+	//
+	bool ContextFreeGrammar::query(const std::string& word, QueryStats* stats) const {
+		return check(word, threads, false, stats) == QueryResult::accepted;
+	}
+
+//----------------------------------------------------------------
+
+	// Check if a word can be generated within the limits of a query
+	//
+	// Inputs:
+	//		- const std::string& word: the given word
+	//		- const QueryOptions& options: the limits of the tree search
+	//		- QueryStats* stats: where to store what the query did (nullptr if not needed)
+	//
+	// Outputs:
+	//		- QueryResult: accepted, rejected or limitExceeded if the tree
+	//			search stopped at a limit before it knew
+	//
+	QueryResult ContextFreeGrammar::query(const std::string& word, const QueryOptions& options,
+		QueryStats* stats) const {
+		return check(word, threads, false, stats, &options);
+	}
+
+//----------------------------------------------------------------
+
+	// Check many words at once with a pool of threads
+	//
+	// Every thread takes the next word that nobody has taken yet, so a slow word
+	// does not hold back the rest. The grammar is only read by the threads and
+	// every search keeps its state on its own, so nothing is locked while the
+	// words are checked
+	//
+	// Inputs:
+	//		- std::span<const std::string> words: the words to check
+	//		- unsigned int nThreads: the number of threads (0 for one per core)
+	//		- QueryStats* stats: where what the queries did is added up (nullptr if not needed)
+	//
+	// Outputs:
+	//		- std::vector<bool>: if every word was accepted (in the order of 'words')
+	//
+	std::vector<bool> ContextFreeGrammar::check_words(std::span<const std::string> words,
+		unsigned int nThreads, QueryStats* stats) const {
+
+		std::vector<QueryResult> results = check_all(words, nThreads, stats, nullptr);
+
+		std::vector<bool> accepted(results.size());
+		for (size_t i = 0; i < results.size(); ++i)
+			accepted[i] = results[i] == QueryResult::accepted;
+		return accepted;
+
+	} // of function check_words
+
+//----------------------------------------------------------------
+
+	// Check many words at once within the limits of a query for every word
+	//
+	// Inputs:
+	//		- std::span<const std::string> words: the words to check
+	//		- const QueryOptions& options: the limits of every tree search
+	//		- unsigned int nThreads: the number of threads (0 for one per core)
+	//		- QueryStats* stats: where what the queries did is added up (nullptr if not needed)
+	//
+	// Outputs:
+	//		- std::vector<QueryResult>: the result of every word (in the order of 'words')
+	//
+	std::vector<QueryResult> ContextFreeGrammar::query_words(std::span<const std::string> words,
+		const QueryOptions& options, unsigned int nThreads, QueryStats* stats) const {
+		return check_all(words, nThreads, stats, &options);
+	}
+
+//----------------------------------------------------------------
+
+	// Check many words with a pool of threads
+	//
+	// Every thread takes the next word that nobody has taken yet, so a slow word
+	// does not hold back the rest. The grammar is only read by the threads and
+	// every search keeps its state on its own, so nothing is locked while the
+	// words are checked
+	//
+	// Inputs:
+	//		- std::span<const std::string> words: the words to check
+	//		- unsigned int nThreads: the number of threads (0 for one per core)
+	//		- QueryStats* stats: where what the queries did is added up (nullptr if not needed)
+	//		- const QueryOptions* options: the limits of every query (nullptr for none)
+	//
+	// Outputs:
+	//		- std::vector<QueryResult>: the result of every word (in the order of 'words')
+	//
+	std::vector<QueryResult> ContextFreeGrammar::check_all(std::span<const std::string> words,
+		unsigned int nThreads, QueryStats* stats, const QueryOptions* options) const {
+
+		if (!nThreads) nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+		nThreads = static_cast<unsigned int>(std::min<size_t>(nThreads, words.size()));
+
+		// Every thread writes only the results of the words it took
+		std::vector<QueryResult> results(words.size(), QueryResult::rejected);
+		std::atomic<size_t> next{ 0 };
+
+		// Every thread adds up its own queries and the totals are merged at the end
+		std::mutex statsLock;
+
+		auto work = [&]() {
+			QueryStats total{ stats && stats->timed };
+			QueryStats single{ stats && stats->timed };
+			for (size_t i = next++; i < words.size(); i = next++) {
+				results[i] = check(words[i], 1, false, stats ? &single : nullptr, options);
+				if (stats) total.add(single);
+			}
+			if (stats) {
+				std::lock_guard<std::mutex> guard{ statsLock };
+				stats->add(total);
+			}
+		};
+
+		std::vector<std::thread> pool;
+		for (unsigned int i = 1; i < nThreads; ++i)
+			pool.emplace_back(work);
+		work();
+
+		for (std::thread& thread : pool)
+			thread.join();
+
+		return results;
+
+	} // of function check_all
+
+//----------------------------------------------------------------
+
+	// Check if a word can be generated from 'this' grammar, using the
+	// result cache if it is enabled
+	//
+	// Inputs:
+	//		- const std::string& word: the given word
+	//		- unsigned int nThreads: the number of threads of the tree search
+	//		- bool showSolution: print the derivation the tree search finds
+	//		- QueryStats* stats: where to store what the query did (nullptr if not needed)
+	//		- const QueryOptions* options: the limits of the query (nullptr for none)
+	//
+	// Outputs:
+	//		- QueryResult: accepted, rejected or limitExceeded (which is never cached)
+	//
+	QueryResult ContextFreeGrammar::check(const std::string& word, unsigned int nThreads,
+		bool showSolution, QueryStats* stats, const QueryOptions* options) const {
+
+		if (stats) stats->clear();
+
+		// Only the tree search finds a derivation to show
+		bool needDerivation = showSolution && engine == Engine::treeSearch;
+
+		bool accepted = false;
+		std::vector<std::string> derivation;
+
+		// An accepted word whose derivation must be shown is checked again
+		// if the cache does not keep the derivations
+		if (!cache || !cache->find(word, needDerivation, accepted, derivation)) {
+
+			QueryResult result = recognize(word, nThreads, needDerivation || (cache && cache->keeps_derivations())
+				? &derivation : nullptr, stats, options);
+			if (result == QueryResult::limitExceeded) return result;
+
+			accepted = result == QueryResult::accepted;
+			if (cache)
+				cache->insert(word, accepted, derivation);
+		}
+
+		if (accepted && needDerivation && !derivation.empty())
+			show_solution(derivation);
+
+		return accepted ? QueryResult::accepted : QueryResult::rejected;
+
+	} // of function check
+
+//----------------------------------------------------------------
+
+	// Check if a word can be generated from 'this' grammar with the chosen engine
+	//
+	// Inputs:
+	//		- const std::string& word: the given word
+	//		- unsigned int nThreads: the number of threads of the tree search
+	//		- std::vector<std::string>* derivation: where the tree search stores the
+	//			derivation it finds (nullptr if it is not needed)
+	//		- QueryStats* stats: where the tree search stores what it did (nullptr if not needed)
+	//		- const QueryOptions* options: the limits of the tree search (nullptr for none)
+	//
+	// Outputs:
+	//		- QueryResult: accepted, rejected or limitExceeded if the tree
+	//			search stopped at a limit before it knew
+	//
+	QueryResult ContextFreeGrammar::recognize(const std::string& word, unsigned int nThreads,
+		std::vector<std::string>* derivation, QueryStats* stats, const QueryOptions* options) const {
+
+		auto answer = [](bool accepted) {
+			return accepted ? QueryResult::accepted : QueryResult::rejected;
+		};
+
+		// The empty word can only be generated if the initial symbol is nullable
+		if (word.empty()) return answer(acceptsEmpty);
 
 		// Check if any symbol from 'word' is not part of the terminal symbols
 		for (char ch : word)
-			if (!termSymbols.contains(ch))
-				return false;
+			if (!symbols.is_terminal(ch))
+				return QueryResult::rejected;
+
+		if (engine == Engine::cyk)
+			return answer(cykParser.recognize(word));
+
+		if (engine == Engine::earley)
+			return answer(earleyParser.recognize(word));
+
+		if (engine == Engine::table)
+			return answer(tableParser.recognize(word));
+
+		// The clock of a timeout starts here
+		QueryBudget budget{ options };
+
+		// Keep only the path of a depth-first search
+		if (ordering == Ordering::iterativeDeepening) {
+			IterativeDeepening search{ word, symbols, maxRuleGenLen, expansion, transpositionBytes };
+			TreeNode* solutionNode = search.run(initialSymbol, stats, &budget);
+			if (solutionNode && derivation)
+				*derivation = derivation_of(solutionNode);
+			if (!solutionNode && search.limit_exceeded())
+				return QueryResult::limitExceeded;
+			return answer(solutionNode);
+		}
+
+		// Spread the search over many threads (A* needs one order of all the
+		// nodes, so it always searches in this thread)
+		if (nThreads > 1 && ordering != Ordering::aStar) {
+			ParallelSearch search{ word, symbols, maxRuleGenLen, expansion,
+				visitedMode, visitedBloomBits };
+			TreeNode* solutionNode = search.run(initialSymbol, nThreads, stats, &budget);
+			if (solutionNode && derivation)
+				*derivation = derivation_of(solutionNode);
+			if (!solutionNode && search.limit_exceeded())
+				return QueryResult::limitExceeded;
+			return answer(solutionNode);
+		}
+
+		// Count the terminal symbols of the word once for the pruning
+		SearchTarget target{ word, symbols };
+
+		// All the nodes of the search and their words live in this arena
+		// and are released together when the search ends
+		Arena arena;
 
 		// Creating the root node for the tree
-		TreeNode* root = new TreeNode{ nullptr, std::string{initialSymbol}, 0, 1 };
-		
+		TreeNode* root = arena.make<TreeNode>(nullptr, arena.store(std::string{ initialSymbol }), 0u, 1u);
+
+		// A* orders the nodes by their depth plus the lower bound of the steps
+		// they still need and, between them, takes the one that needs the fewest
+		bool aStar = ordering == Ordering::aStar;
+		std::optional<StepBounds> bounds;
+		if (aStar) {
+			bounds.emplace(target, symbols, expansion);
+			root->heuristic = bounds->estimate(root->word);
+		}
+
+		// The nodes may keep only their rules and get their words back when they
+		// are expanded (A* looks the words of the nodes up, so it keeps them)
+		bool delta = nodeEncoding == NodeEncoding::rules && !aStar;
+		WordRebuilder rebuilder{ symbols, expansion };
+		std::vector<uint16_t> childRules;
+		size_t rulesPerChild = 0;
+
 		// Adding the node to the frontier
-		FrontierNode* frontierHead = new FrontierNode{ root };
-		FrontierNode* frontierTail = frontierHead;
+		BucketFrontier frontier;
+#ifndef HEURISTIC
+		FrontierNode* frontierHead = nullptr;
+		FrontierNode* frontierTail = nullptr;
+#endif // HEURISTIC
 
-		// Creating a vector for the nodes that will be used to delete them
-		// after searcing for a solution
-		std::vector<TreeNode*> to_be_deleted_nodes;
+		auto push = [&](TreeNode* node) {
+			if (aStar)
+				frontier.push(node, node->depth + node->heuristic, node->heuristic);
+			else {
+#ifdef HEURISTIC
+				frontier.push(node);
+#else
+				add_to_back(&frontierHead, &frontierTail, node, arena);
+#endif // HEURISTIC
+			}
+		};
 
-		// Creating a set for the words added to the tree
-		std::unordered_set<std::string> wordSet{ root->word };
+		auto pop = [&]() {
+#ifndef HEURISTIC
+			if (!aStar) return get_front(&frontierHead, &frontierTail);
+#endif // HEURISTIC
+			return frontier.pop();
+		};
 
-		// A TreeNode-pointer vector to store the children generated in every loop
-		std::vector<TreeNode*> children;
+		push(root);
+
+		// Creating a set for the words added to the tree
+		// (with VisitedSet::Mode::exact the views point to the words in the arena)
+		// A* keeps the least depth of every word instead, so that a word found
+		// again with fewer steps gets a new node (its older node is skipped)
+		// (the nodes that keep their rules have no words to point to, so an
+		// exact set keeps 128 bit fingerprints of the words instead)
+		VisitedSet wordSet{ delta && visitedMode == VisitedSet::Mode::exact
+			? VisitedSet::Mode::fingerprint128 : visitedMode, visitedBloomBits };
+		std::unordered_map<std::string_view, unsigned int> bestDepths;
+		if (aStar)
+			bestDepths[root->word] = 0;
+		else
+			wordSet.insert(root->word);
+
+		auto visitedBytes = [&]() {
+			if (!aStar) return wordSet.bytes();
+			return bestDepths.bucket_count() * sizeof(void*)
+				+ bestDepths.size() * (sizeof(std::string_view) + sizeof(unsigned int) + 2 * sizeof(void*));
+		};
+
+		// A vector to store the words of the children generated in every loop
+		// (its strings keep their memory between the loops)
+		std::vector<std::string> childWords;
 
 		// A variable to store the TreeNode that the solution will be found
 		TreeNode* solutionNode = nullptr;
+		bool limitExceeded = false;
+
+		// The counters are cheap enough to keep even when nobody asks for them
+		// (the cuts of the pruning and the times are only kept in 'stats')
+		size_t nExpanded = 0;
+		size_t nGenerated = 1;
+		size_t frontierSize = 1;
+		size_t peakFrontier = 1;
+		double* pruningSeconds = stats && stats->timed ? &stats->pruningSeconds : nullptr;
 
 		// Loop until frontierHead variable "is empty" or if a solution was found
 		while (true) {
 
 			// Get the next to be expanded leef node
-			TreeNode* currNode = get_front(&frontierHead, &frontierTail);
-			to_be_deleted_nodes.push_back(currNode);
+			TreeNode* currNode = pop();
 			if (!currNode) break;
+			--frontierSize;
+
+			// A node whose word was reached again with fewer steps is left behind
+			if (aStar && currNode->depth > bestDepths[currNode->word]) continue;
+
+			// The node that is expanded has its word
+			TreeNode expanded = *currNode;
+			if (delta)
+				expanded.word = rebuilder.word_of(currNode);
 
 			// Check if it holds the solution
-			if (currNode->word == word) {
+			if (expanded.word == word) {
 				solutionNode = currNode;
 				break;
 			}
 
-#ifdef SHOW_DETAILS
-			{
-				using namespace std::chrono;
-
-				auto time = system_clock::now();
-
-				std::cout << currNode->word << '\n';
-#endif // SHOW_DETAILS
-
-				// Generate children nodes and add them to frontier
-				generate_children(currNode, ruleMap, children, nonTermSymbols);
-
-#ifdef SHOW_DETAILS
-				std::cout << "Generation time: "
-					<< duration_cast<milliseconds>(system_clock::now() - time).count()
-					<< " ms\n";
-#endif // SHOW_DETAILS
-
-#ifdef SHOW_DETAILS
-				time = system_clock::now();
-#endif // SHOW_DETAILS
-
-				// Prune the node if it is already in the tree
-				// or if there is no possible way to find a solution throught it
-				for (int i = 0; i < children.size(); ++i)
-					if (prune(word, children[i], wordSet, termSymbols, nonTermSymbols, maxRuleGenLen)) {
-#ifdef SHOW_PRUNED
-						std::cout << children[i]->word << '\n';
-#endif // SHOW_PRUNED
-						delete children[i];
-						children[i] = nullptr;
-					}
-					else {
-#ifdef SHOW_GENERATED
-						std::cout << children[i]->word << '\n';
-#endif // SHOW_GENERATED
-						wordSet.insert(children[i]->word);
-					}
-
-#ifdef SHOW_DETAILS
-				std::cout << "Prune time: "
-					<< duration_cast<milliseconds>(system_clock::now() - time).count()
-					<< " ms\n\n";
+			// Stop before the expansion that would go over a limit
+			if (budget.limited() && budget.exceeded(nExpanded, arena.bytes_reserved() + visitedBytes())) {
+				limitExceeded = true;
+				break;
 			}
-#endif // SHOW_DETAILS
 
-			// Add children to the back of the frontier
-			for (int i = 0; i < children.size(); ++i)
-				if (children[i]) {
-#ifdef HEURISTIC
-					add_in_order(&frontierHead, &frontierTail, children[i]);
-#else
-					add_to_back(&frontierHead, &frontierTail, children[i]);
-#endif // HEURISTIC
+			// Generate the words of the children that survive the pruning
+			// (the ones that cannot find a solution are cut while they are generated)
+			size_t nChildren = delta
+				? generate_children(&expanded, target, symbols, maxRuleGenLen, expansion,
+					childWords, childRules, rulesPerChild, stats)
+				: generate_children(currNode, target, symbols, maxRuleGenLen, expansion, childWords, stats);
+			++nExpanded;
+
+			// Only the words that are not already in the tree get a node
+			// and are added to the frontier
+			for (size_t i = 0; i < nChildren; ++i) {
+
+				bool seen;
+				{
+					ScopedTimer timer{ pruningSeconds };
+					if (aStar) {
+						auto found = bestDepths.find(childWords[i]);
+						seen = found != bestDepths.end() && found->second <= currNode->depth + 1;
+					}
+					else
+						seen = wordSet.contains(childWords[i]);
+				}
+				if (seen) {
+					count_pruned(stats, PruneRule::duplicate);
+					continue;
 				}
-			children.clear();
+
+				TreeNode* child = delta
+					? create_child(currNode, childWords[i], &childRules[i * rulesPerChild], rulesPerChild, symbols, arena)
+					: create_child(currNode, childWords[i], symbols, arena);
+				if (aStar) {
+					child->heuristic = bounds->estimate(child->word);
+					bestDepths[child->word] = child->depth;
+				}
+				else
+					wordSet.insert(delta ? std::string_view{ childWords[i] } : child->word);
+				++nGenerated;
+				push(child);
+				++frontierSize;
+			}
+			peakFrontier = std::max(peakFrontier, frontierSize);
 
 		} // while(true) (generation loop)
 
-		// If a solution was found print it
-		bool solutionFound = solutionNode;
-		if(solutionNode)
-			show_solution(solutionNode, nonTermSymbols);
+		if (stats) {
+			stats->nodesExpanded = nExpanded;
+			stats->nodesGenerated = nGenerated;
+			stats->bytes = arena.bytes_reserved() + visitedBytes();
+			stats->peakFrontier = peakFrontier;
+			stats->peakVisited = aStar ? bestDepths.size() : wordSet.size();
+		}
+
+		// If a solution was found keep its derivation
+		// (the nodes that keep their rules replay them from the root)
+		if (solutionNode && derivation)
+			*derivation = delta ? rebuilder.derivation_of(solutionNode) : derivation_of(solutionNode);
+
+		if (limitExceeded) return QueryResult::limitExceeded;
+		return answer(solutionNode);
+
+	} // of function recognize
+
+//----------------------------------------------------------------
+
+	// Choose the algorithm that check_word will use
+	//
+	// Inputs:
+	//		- Engine e: the algorithm to use
+	//
+	// Outputs:
+	//		- bool true: the algorithm was chosen
+	//		- bool false: Engine::table was asked but the grammar has conflicts
+	//
+	bool ContextFreeGrammar::set_engine(Engine e) {
+
+		if (e == Engine::table && tableParser.get_kind() == TableParser::Kind::none)
+			return false;
+
+		engine = e;
+		return true;
+
+	} // of function set_engine
+
+//----------------------------------------------------------------
+
+	// Choose what the nodes of the tree search keep
+	//
+	// Inputs:
+	//		- NodeEncoding e: the encoding of the nodes
+	//
+	// Outputs:
+	//		- bool true: the encoding was chosen
+	//		- bool false: a symbol has more rules than the nodes can tell apart
+	//
+	bool ContextFreeGrammar::set_node_encoding(NodeEncoding e) {
+
+		if (e == NodeEncoding::rules)
+			for (size_t a = 0; a < symbols.n_non_terminals(); ++a)
+				if (symbols.rules_of(symbols.non_terminal(a)).size() > size_t{ UINT16_MAX } + 1)
+					return false;
+
+		nodeEncoding = e;
+		return true;
+
+	} // of function set_node_encoding
+
+//----------------------------------------------------------------
+
+	// Choose how many threads the tree search uses
+	//
+	// Inputs:
+	//		- unsigned int n: the number of threads (0 for one per core)
+	//
+	// Outputs:
+	//
+	void ContextFreeGrammar::set_threads(unsigned int n) {
+
+		if (!n) n = std::max(std::thread::hardware_concurrency(), 1u);
+		threads = n;
+
+	} // of function set_threads
+
+//----------------------------------------------------------------
+
+	// Get the name of the algorithm that check_word uses
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- std::string: the name of the algorithm
+	//
+	std::string ContextFreeGrammar::engine_name() const {
+
+		if (engine == Engine::cyk) return "CYK";
+		if (engine == Engine::earley) return "Earley";
+		if (engine == Engine::table)
+			return tableParser.get_kind() == TableParser::Kind::ll1 ? "LL(1) table" : "LALR(1) table";
+		std::string name = expansion == Expansion::leftmost ? "leftmost tree search" : "tree search";
+		if (ordering == Ordering::aStar) return "A* " + name;
+		if (ordering == Ordering::iterativeDeepening) return "IDA* " + name;
+		return name;
+
+	} // of function engine_name
+
+//----------------------------------------------------------------
+
+	// Draw words of a length uniformly at random or their rejected neighbours
+	//
+	// Inputs:
+	//		- size_t length: the length of the words
+	//		- size_t count: how many words
+	//		- uint64_t seed: the same seed gives the same words
+	//		- bool rejected: if the words must not be generated
+	//
+	// Outputs:
+	//		- std::vector<std::string>: the words (fewer than 'count' if
+	//			there are no words or too few rejected ones of 'length')
+	//
+	std::vector<std::string> ContextFreeGrammar::generate_words(size_t length, size_t count,
+		uint64_t seed, bool rejected) const {
+
+		return generate_words(WordSampler{ symbols, initialSymbol, length }, length, count, seed, rejected);
+
+	} // of function generate_words
+
+//----------------------------------------------------------------
+
+	// Draw words of a length with a sampler that is kept for many calls
+	//
+	// A rejected word is a drawn word with one symbol changed by
+	// WordSampler::mutate_rejected to one that cannot be next to its
+	// neighbours, which needs no parser. If no symbol of the word can be
+	// changed like that (every two terminal symbols can be neighbours) it is
+	// changed by WordSampler::mutate and checked with the table of 'this'
+	// grammar or with CYK, and the changes that are still generated are
+	// dropped (at most 64 tries per word asked for)
+	//
+	// Inputs:
+	//		- const WordSampler& wordSampler: a sampler of 'this' grammar
+	//		- size_t length: the length of the words (at most the longest of the sampler)
+	//		- size_t count: how many words
+	//		- uint64_t seed: the same seed gives the same words
+	//		- bool rejected: if the words must not be generated
+	//
+	// Outputs:
+	//		- std::vector<std::string>: the words (fewer than 'count' if
+	//			there are no words or too few rejected ones of 'length')
+	//
+	std::vector<std::string> ContextFreeGrammar::generate_words(const WordSampler& wordSampler,
+		size_t length, size_t count, uint64_t seed, bool rejected) const {
+
+		std::vector<std::string> words;
+
+		// The empty word is the only one of length 0
+		if (!length) {
+			if (acceptsEmpty && !rejected) words.assign(count, "");
+			return words;
+		}
+
+		if (!wordSampler.has_words(length)) return words;
+
+		auto generated = [&](const std::string& word) {
+			if (wordSampler.has_impossible_neighbours(word)) return false;
+			return tableParser.get_kind() != TableParser::Kind::none
+				? tableParser.recognize(word) : cykParser.recognize(word);
+		};
+
+		std::mt19937_64 rng{ seed };
+		std::string word;
+		words.reserve(count);
+		for (size_t attempt = 0; words.size() < count && attempt < 64 * count; ++attempt) {
+			wordSampler.sample(length, rng, word);
+			if (rejected && !wordSampler.mutate_rejected(word, rng)) {
+				wordSampler.mutate(word, rng);
+				if (generated(word)) continue;
+			}
+			words.push_back(word);
+		}
 
-		clear_tree(frontierHead);
-		for (size_t i = 0; i < to_be_deleted_nodes.size(); ++i)
-			delete to_be_deleted_nodes[i];
-		return solutionFound;
+		return words;
 
-	} // of function check_word
+	} // of function generate_words
 
 //----------------------------------------------------------------
 
@@ -7,7 +7,13 @@
 
 #include <string>
 #include <fstream>
+#include <span>
+#include <optional>
+#include <mutex>
+#include <atomic>
 #include <vector>
+#include <memory>
+#include <thread>
 #include <algorithm>
 #include <unordered_set>
 #include <unordered_map>
@@ -17,14 +23,24 @@
 #include "Macros.h"
 
 #include "GramErr.h"
+#include "Symbols.h"
 #include "Tree.h"
+#include "ParSearch.h"
+#include "Deepening.h"
+#include "Visited.h"
+#include "Cache.h"
+#include "Binary.h"
+#include "Stats.h"
+#include "Budget.h"
+#include "Sampler.h"
+#include "Forest.h"
+#include "Normalize.h"
+#include "Cyk.h"
+#include "Earley.h"
+#include "TblParser.h"
 
 //----------------------------------------------------------------
 
-#ifdef SHOW_DETAILS
-#include <chrono>
-#endif // SHOW_DETAILS
-
 namespace Grammars {
 
 //----------------------------------------------------------------
@@ -34,29 +50,210 @@ namespace Grammars {
 	class ContextFreeGrammar {
 	public:
 
+		// The algorithms that can be used to check a word
+		enum class Engine {
+			treeSearch,		// Search the derivations of the initial symbol (shows the solution)
+			cyk,			// CYK on a Chomsky Normal Form copy of the rules, O(n^3)
+			earley,			// Earley on the rules with Leo's optimization, O(n^3) and O(n) for LR(k) grammars
+			table			// The LL(1) or LALR(1) table of a deterministic grammar, O(n)
+		};
+
 		// Define a grammar by reading its terminal,
 		// non-Terminal symbols and rules
+		// (or by loading the tables of a file written by 'compile')
 		ContextFreeGrammar(std::string infile);
 
+		// Write the normalized rules and the tables of every engine to a binary
+		// file that the constructor loads without parsing or normalizing again
+		void compile(const std::string& outfile) const;
+
 		// Check if a word can be generated with 'this' grammar
 		bool check_word(std::string word) const;
 
+		// Check a word without printing the derivation and, if 'stats' is given,
+		// store what the query did in it
+		bool query(const std::string& word, QueryStats* stats = nullptr) const;
+
+		// Check a word within the limits of 'options' (QueryResult::limitExceeded
+		// if the tree search stops before it knows, with the stats so far)
+		QueryResult query(const std::string& word, const QueryOptions& options,
+			QueryStats* stats = nullptr) const;
+
+		// Check many words with a pool of threads and return the results in the
+		// same order (the derivations are not printed) and, if 'stats' is
+		// given, add up what the queries did in it
+		std::vector<bool> check_words(std::span<const std::string> words,
+			unsigned int nThreads = 0, QueryStats* stats = nullptr) const;
+
+		// Check many words like check_words with the limits of 'options' for
+		// every word (a timeout starts again for every word)
+		std::vector<QueryResult> query_words(std::span<const std::string> words,
+			const QueryOptions& options, unsigned int nThreads = 0, QueryStats* stats = nullptr) const;
+
+		// Choose the algorithm that check_word will use for 'this' grammar
+		// Engine::table can only be chosen if the grammar has no conflicts
+		bool set_engine(Engine e);
+
+		// Get the algorithm that check_word uses for 'this' grammar
+		Engine get_engine() const { return engine; }
+
+		// Choose which non-terminal symbols the tree search replaces in every expansion
+		void set_expansion(Expansion e) { expansion = e; }
+
+		// Get which non-terminal symbols the tree search replaces in every expansion
+		Expansion get_expansion() const { return expansion; }
+
+		// Choose the order in which the tree search expands its nodes
+		// (Ordering::aStar and Ordering::iterativeDeepening find a shortest
+		// derivation and always use one thread)
+		void set_ordering(Ordering o) { ordering = o; }
+
+		// Get the order in which the tree search expands its nodes
+		Ordering get_ordering() const { return ordering; }
+
+		// Choose what the nodes of the tree search keep: NodeEncoding::rules
+		// keeps only the rules of every node and rebuilds the words (less memory
+		// for long words but more time; the A* ordering and the threads keep
+		// the words). The nodes then do not keep their words for the visited
+		// set, so an exact visited set keeps 128 bit fingerprints of them
+		// instead (VisitedSet::Mode::fingerprint128 with its small risk)
+		// NodeEncoding::rules can only be chosen if every symbol has at most
+		// 65536 rules (the nodes keep the index of every rule in 16 bits)
+		bool set_node_encoding(NodeEncoding e);
+
+		// Get what the nodes of the tree search keep
+		NodeEncoding get_node_encoding() const { return nodeEncoding; }
+
+		// Choose the memory of the transposition table of Ordering::iterativeDeepening
+		// (0 for none: the words are not checked for duplicates)
+		void set_transposition_bytes(size_t bytes) { transpositionBytes = bytes; }
+
+		// Get the memory of the transposition table of Ordering::iterativeDeepening
+		size_t get_transposition_bytes() const { return transpositionBytes; }
+
+		// Choose how many threads the tree search uses (0 for one per core)
+		void set_threads(unsigned int n);
+
+		// Get how many threads the tree search uses
+		unsigned int get_threads() const { return threads; }
+
+		// Choose how the tree search keeps the words it has seen and the size
+		// of the Bloom filter in front of them (see VisitedSet for the risk of
+		// the fingerprint modes)
+		void set_visited_set(VisitedSet::Mode mode, size_t bloomBits = 0) {
+			visitedMode = mode;
+			visitedBloomBits = bloomBits;
+		}
+
+		// Keep the results of check_word and check_words in a cache of at most
+		// 'maxBytes' bytes that drops the least recently used results first
+		// (with 'keepDerivations' the tree search derivations are kept too)
+		// The copies of 'this' grammar share the cache
+		void enable_cache(size_t maxBytes, bool keepDerivations = false) {
+			cache = std::make_shared<ResultCache>(maxBytes, keepDerivations);
+		}
+
+		// Stop keeping the results of check_word and drop them
+		void disable_cache() { cache.reset(); }
+
+		// Get the hits, misses and evictions of the cache (all zero if it is disabled)
+		CacheStats cache_stats() const { return cache ? cache->stats() : CacheStats{}; }
+
+		// Count the derivations of 'this' grammar up to 'maxLength' once to draw
+		// many words from them (the sampler must not outlive 'this' grammar)
+		WordSampler sampler(size_t maxLength) const { return WordSampler{ symbols, initialSymbol, maxLength }; }
+
+		// Build the forest of every derivation of a word with the rules as they
+		// are written in polynomial time (the forest must not outlive 'this' grammar)
+		ParseForest parse_forest(const std::string& word) const {
+			return ParseForest{ symbols, initialSymbol, grammarRules, word };
+		}
+
+		// Count the derivations of a word exactly with the rules as they are
+		// written (zero if it is not generated, nothing if it has infinitely many)
+		std::optional<BigUnsigned> count_derivations(const std::string& word) const {
+			ParseForest forest = parse_forest(word);
+			if (forest.infinite()) return std::nullopt;
+			return forest.count();
+		}
+
+		// Draw 'count' words of exactly 'length' uniformly at random from the
+		// derivations of 'this' grammar, or with 'rejected' words of that length
+		// that are one change away from them and are not generated (fewer words
+		// are returned if there are not enough of them)
+		// The derivations are the ones of the normalized rules, so with an
+		// ambiguous grammar the words are not uniform: a word with more
+		// derivations is drawn more often
+		std::vector<std::string> generate_words(size_t length, size_t count,
+			uint64_t seed, bool rejected = false) const;
+
+		// Draw words like above with a sampler of 'this' grammar, so the counts
+		// are built once for many calls ('length' must be at most its maximum)
+		std::vector<std::string> generate_words(const WordSampler& wordSampler, size_t length,
+			size_t count, uint64_t seed, bool rejected = false) const;
+
+		// Get the symbols of 'this' grammar with the normalized rules
+		const SymbolTable& get_symbols() const { return symbols; }
+
+		// Get the initial symbol of 'this' grammar
+		char get_initial_symbol() const { return initialSymbol; }
+
+		// Get the name of the algorithm that check_word uses (for example "LALR(1) table")
+		std::string engine_name() const;
+
+		// Get how long every step of the normalization of the rules took
+		const std::vector<NormalizationStep>& normalization_report() const { return normalizationReport; }
+
 		// Get the name of the input file for 'this' grammar
 		operator std::string() const { return filename; }
 
 	private:
 
+		// Load the tables of a compiled grammar
+		void load_compiled(const std::string& infile);
+
+		// Check a word with a number of threads for the tree search
+		QueryResult check(const std::string& word, unsigned int nThreads, bool showSolution,
+			QueryStats* stats = nullptr, const QueryOptions* options = nullptr) const;
+
+		// Check many words with a pool of threads
+		std::vector<QueryResult> check_all(std::span<const std::string> words, unsigned int nThreads,
+			QueryStats* stats, const QueryOptions* options) const;
+
+		// Check a word with the chosen engine and keep the derivation of the tree search
+		QueryResult recognize(const std::string& word, unsigned int nThreads,
+			std::vector<std::string>* derivation, QueryStats* stats, const QueryOptions* options) const;
+
 		std::string filename;
 
 		char initialSymbol;
 
-		std::unordered_set<char> termSymbols;
-		std::unordered_set<char> nonTermSymbols;
+		SymbolTable symbols;
 
 		std::unordered_map<char, std::vector<std::string>> ruleMap;
 
+		// The rules as they are written in the file, with the empty and the
+		// unit rules (the parse forests count the derivations with them)
+		std::vector<std::pair<char, std::string>> grammarRules;
+
 		size_t maxRuleGenLen;
 
+		bool acceptsEmpty;
+		std::vector<NormalizationStep> normalizationReport;
+
+		Engine engine;
+		Expansion expansion;
+		Ordering ordering;
+		size_t transpositionBytes;		// The table of Ordering::iterativeDeepening (0 for none)
+		NodeEncoding nodeEncoding;
+		unsigned int threads;
+		VisitedSet::Mode visitedMode;
+		size_t visitedBloomBits;
+		std::shared_ptr<ResultCache> cache;
+		CykParser cykParser;
+		EarleyParser earleyParser;
+		TableParser tableParser;
+
 	}; // of class ConFreeGrammar
 
 	// Check if an automaton is already defined
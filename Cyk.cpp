@@ -0,0 +1,198 @@
+
+//----------------------------------------------------------------
+
+#include "Cyk.h"
+
+//----------------------------------------------------------------
+
+#include <map>
+#include <bit>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Build the masks used by 'recognize'
+	//
+	// Inputs:
+	//		- const CnfGrammar& cnf: the rules in Chomsky Normal Form
+	//
+	// Outputs:
+	//
+	CykParser::CykParser(const CnfGrammar& cnf)
+		: nNonTerms{ cnf.nNonTerms }, start{ cnf.start } {
+
+		nWords = (nNonTerms + 63) / 64;
+
+		// Every symbol that produces a terminal
+		terminalMasks.assign(256 * nWords, 0);
+		for (const auto& rule : cnf.termRules)
+			terminalMasks[static_cast<unsigned char>(rule.second) * nWords + rule.first / 64] |=
+				uint64_t{ 1 } << (rule.first % 64);
+
+		// Group the binary rules by their output so every pair X Y has one mask
+		std::map<std::pair<size_t, size_t>, size_t> pairHeads;
+		joins.assign(nNonTerms, {});
+		rightMasks.assign(nNonTerms * nWords, 0);
+		for (const auto& rule : cnf.binaryRules) {
+			auto [it, inserted] = pairHeads.insert({ rule.second, headMasks.size() });
+			if (inserted) {
+				headMasks.resize(headMasks.size() + nWords, 0);
+				joins[rule.second.first].push_back({ rule.second.second, it->second });
+				rightMasks[rule.second.first * nWords + rule.second.second / 64] |=
+					uint64_t{ 1 } << (rule.second.second % 64);
+			}
+			headMasks[it->second + rule.first / 64] |= uint64_t{ 1 } << (rule.first % 64);
+		}
+
+	} // of constructor CykParser
+
+//----------------------------------------------------------------
+
+	// Read the masks that 'write' stored in a compiled grammar
+	//
+	// Inputs:
+	//		- BinaryReader& in: the compiled grammar
+	//
+	// Outputs:
+	//
+	CykParser::CykParser(BinaryReader& in) {
+
+		nNonTerms = in.get<uint64_t>();
+		nWords = (nNonTerms + 63) / 64;
+		start = in.get<uint64_t>();
+
+		std::span<const uint64_t> masks = in.get_array<uint64_t>();
+		terminalMasks.assign(masks.begin(), masks.end());
+		masks = in.get_array<uint64_t>();
+		rightMasks.assign(masks.begin(), masks.end());
+		masks = in.get_array<uint64_t>();
+		headMasks.assign(masks.begin(), masks.end());
+
+		// The joins of every symbol follow each other
+		std::span<const uint64_t> nJoins = in.get_array<uint64_t>();
+		std::span<const Join> allJoins = in.get_array<Join>();
+		if (terminalMasks.size() != 256 * nWords || rightMasks.size() != nNonTerms * nWords
+			|| nJoins.size() != nNonTerms || (nNonTerms && start >= nNonTerms))
+			in.fail();
+
+		joins.assign(nNonTerms, {});
+		size_t next = 0;
+		for (size_t x = 0; x < nNonTerms; ++x) {
+			if (nJoins[x] > allJoins.size() - next) in.fail();
+			joins[x].assign(allJoins.begin() + next, allJoins.begin() + next + nJoins[x]);
+			next += nJoins[x];
+		}
+		for (const std::vector<Join>& list : joins)
+			for (const Join& join : list)
+				if (join.right >= nNonTerms || join.heads + nWords > headMasks.size())
+					in.fail();
+
+	} // of constructor CykParser
+
+//----------------------------------------------------------------
+
+	// Write the masks to a compiled grammar
+	//
+	// Inputs:
+	//		- BinaryWriter& out: the compiled grammar
+	//
+	// Outputs:
+	//
+	void CykParser::write(BinaryWriter& out) const {
+
+		out.put<uint64_t>(nNonTerms);
+		out.put<uint64_t>(start);
+		out.put_array(terminalMasks);
+		out.put_array(rightMasks);
+		out.put_array(headMasks);
+
+		std::vector<uint64_t> nJoins;
+		std::vector<Join> allJoins;
+		for (const std::vector<Join>& list : joins) {
+			nJoins.push_back(list.size());
+			allJoins.insert(allJoins.end(), list.begin(), list.end());
+		}
+		out.put_array(nJoins);
+		out.put_array(allJoins);
+
+	} // of function write
+
+//----------------------------------------------------------------
+
+	// Check if 'word' can be generated using the CYK algorithm
+	//
+	// The cell (start, length) holds every symbol that produces the subword
+	// of 'word' that begins at 'start' and has 'length' symbols
+	//
+	// Inputs:
+	//		- const std::string& word: the word to check
+	//
+	// Outputs:
+	//		- bool true: 'word' was accepted
+	//		- bool false: 'word' was NOT accepted
+	//
+	bool CykParser::recognize(const std::string& word) const {
+
+		size_t n = word.length();
+		if (!n || !nNonTerms) return false;
+
+		// The chart is stored row by row, one row for every length
+		std::vector<uint64_t> chart(n * (n + 1) / 2 * nWords, 0);
+		std::vector<size_t> rowOffset(n + 1, 0);
+		for (size_t length = 1; length < n; ++length)
+			rowOffset[length + 1] = rowOffset[length] + (n - length + 1) * nWords;
+		auto cell = [&](size_t begin, size_t length) {
+			return &chart[rowOffset[length] + begin * nWords];
+		};
+
+		// The cells of length 1
+		for (size_t i = 0; i < n; ++i) {
+			const uint64_t* mask = &terminalMasks[static_cast<unsigned char>(word[i]) * nWords];
+			std::copy(mask, mask + nWords, cell(i, 1));
+		}
+
+		// Join the cells of every split of the longer subwords
+		for (size_t length = 2; length <= n; ++length)
+			for (size_t begin = 0; begin + length <= n; ++begin) {
+
+				uint64_t* target = cell(begin, length);
+				for (size_t split = 1; split < length; ++split) {
+
+					const uint64_t* left = cell(begin, split);
+					const uint64_t* right = cell(begin + split, length - split);
+
+					for (size_t w = 0; w < nWords; ++w) {
+						uint64_t bits = left[w];
+						while (bits) {
+							size_t x = w * 64 + std::countr_zero(bits);
+							bits &= bits - 1;
+
+							// Skip X if no symbol of 'right' can follow it
+							const uint64_t* follows = &rightMasks[x * nWords];
+							bool any = false;
+							for (size_t v = 0; v < nWords && !any; ++v)
+								any = right[v] & follows[v];
+							if (!any) continue;
+
+							for (const Join& join : joins[x])
+								if (right[join.right / 64] & (uint64_t{ 1 } << (join.right % 64)))
+									for (size_t v = 0; v < nWords; ++v)
+										target[v] |= headMasks[join.heads + v];
+						}
+					}
+				}
+			}
+
+		return cell(0, n)[start / 64] & (uint64_t{ 1 } << (start % 64));
+
+	} // of function recognize
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
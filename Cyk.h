@@ -0,0 +1,71 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Normalize.h"
+#include "Binary.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// A CYK recognizer that works on the Chomsky Normal Form of the rules
+	//
+	// Every chart cell is a bitset over the non-terminal symbols so the join
+	// of two cells is done with word-wide AND/OR operations
+	// The time needed to check a word of length n is O(n^3)
+	//
+	class CykParser {
+	public:
+
+		// An empty parser that accepts nothing
+		CykParser() : nNonTerms{ 0 }, nWords{ 0 }, start{ 0 } {}
+
+		// Build the masks of the rules in Chomsky Normal Form
+		CykParser(const CnfGrammar& cnf);
+
+		// Read the masks from a compiled grammar
+		CykParser(BinaryReader& in);
+
+		// Write the masks to a compiled grammar
+		void write(BinaryWriter& out) const;
+
+		// Check if 'word' can be generated from the initial symbol
+		bool recognize(const std::string& word) const;
+
+	private:
+
+		// A join of the form X Y that produces every symbol in the mask at 'heads'
+		struct Join {
+			size_t right;	// The id of the symbol Y
+			size_t heads;	// The offset of the mask in 'headMasks'
+		};
+
+		size_t nNonTerms;	// The number of non-terminals (including the generated ones)
+		size_t nWords;		// The number of 64-bit words in a mask
+		size_t start;		// The id of the initial symbol
+
+		std::vector<uint64_t> terminalMasks;		// [256 * nWords] symbols that produce a terminal
+		std::vector<uint64_t> rightMasks;			// [nNonTerms * nWords] all the Y that join with X
+		std::vector<uint64_t> headMasks;			// The masks that the joins point to
+		std::vector<std::vector<Join>> joins;		// The joins indexed by X
+
+	}; // of class CykParser
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,300 @@
+
+//----------------------------------------------------------------
+
+#include "Deepening.h"
+
+//----------------------------------------------------------------
+
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Create an empty table
+	//
+	// Inputs:
+	//		- size_t bytes: about how much memory the table uses (at least one slot)
+	//		- size_t maxLength: the longest word it keeps
+	//
+	// Outputs:
+	//
+	TranspositionTable::TranspositionTable(size_t bytes, size_t maxLength)
+		: maxLength{ std::max<size_t>(maxLength, 1) }, pass{ 0 }, count{ 0 } {
+
+		size_t nSlots = std::max<size_t>(bytes / (sizeof(Slot) + this->maxLength), 1);
+		slots.assign(nSlots, Slot{ 0, 0, 0 });
+		words.assign(nSlots * this->maxLength, 0);
+
+	} // of constructor TranspositionTable
+
+//----------------------------------------------------------------
+
+	// Start a new pass
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void TranspositionTable::next_pass() {
+
+		++pass;
+		count = 0;
+
+	} // of function next_pass
+
+//----------------------------------------------------------------
+
+	// Check if a word was reached at 'depth' or less in this pass and keep it if not
+	//
+	// A word reached again with more steps has a subtree that was (or is being)
+	// searched with a bound that leaves it at least as many steps, so it can
+	// only find what the first one finds
+	//
+	// Inputs:
+	//		- std::string_view word: the word of a node
+	//		- unsigned int depth: the depth of the node
+	//
+	// Outputs:
+	//		- bool true: the word was reached at that depth or less
+	//		- bool false: the word is new in this pass or was reached deeper
+	//
+	bool TranspositionTable::seen(std::string_view word, unsigned int depth) {
+
+		if (word.length() > maxLength) return false;
+
+		size_t s = std::hash<std::string_view>{}(word) % slots.size();
+		Slot& slot = slots[s];
+		char* kept = &words[s * maxLength];
+
+		if (slot.pass == pass && slot.length == word.length()
+			&& std::equal(word.begin(), word.end(), kept)) {
+			if (slot.depth <= depth) return true;
+			slot.depth = depth;
+			return false;
+		}
+
+		// A new word takes the slot
+		if (slot.pass != pass) ++count;
+		slot = Slot{ pass, depth, static_cast<uint32_t>(word.length()) };
+		std::memcpy(kept, word.data(), word.length());
+		return false;
+
+	} // of function seen
+
+//----------------------------------------------------------------
+
+	// Prepare a search for a word
+	//
+	// Inputs:
+	//		- const std::string& word: the word to generate (it must outlive the search)
+	//		- const SymbolTable& symbols: the symbols of the grammar with their rules
+	//		- size_t maxRuleGenLen: the longest output of a rule
+	//		- Expansion expansion: which non-terminal symbols an expansion replaces
+	//		- size_t tableBytes: the memory of the TranspositionTable (0 for none)
+	//
+	// Outputs:
+	//
+	IterativeDeepening::IterativeDeepening(const std::string& word, const SymbolTable& symbols,
+		size_t maxRuleGenLen, Expansion expansion, size_t tableBytes)
+		: target{ word, symbols }, symbols{ symbols }, maxRuleGenLen{ maxRuleGenLen },
+		expansion{ expansion }, bounds{ target, symbols, expansion },
+		pathLength{ 0 }, pathBytes{ 0 }, pending{ 0 }, solutionNode{ nullptr },
+		limitExceeded{ false }, nExpanded{ 0 }, nGenerated{ 0 }, peakPending{ 0 } {
+
+		if (tableBytes)
+			table.emplace(tableBytes, word.length());
+
+	} // of constructor IterativeDeepening
+
+//----------------------------------------------------------------
+
+	// Search from the initial symbol with a growing bound
+	//
+	// Inputs:
+	//		- char initialSymbol: the root of the search
+	//		- QueryStats* stats: where what the passes did is stored (nullptr if not needed)
+	//		- const QueryBudget* budget: the limits of the search (nullptr for none)
+	//
+	// Outputs:
+	//		- TreeNode*: the node of the solution (nullptr if there is none or
+	//			if the search stopped at a limit)
+	//
+	TreeNode* IterativeDeepening::run(char initialSymbol, QueryStats* stats,
+		const QueryBudget* budget) {
+
+		solutionNode = nullptr;
+		limitExceeded = false;
+		nExpanded = 0;
+		nGenerated = 0;
+		peakPending = 0;
+		size_t peakVisited = 0;
+		size_t peakBytes = 0;
+
+		unsigned int bound = bounds.estimate(std::string_view{ &initialSymbol, 1 });
+		while (true) {
+
+			unsigned int nextBound = none;
+			pass(initialSymbol, bound, nextBound, stats, budget);
+
+			if (table) peakVisited = std::max(peakVisited, table->size());
+			peakBytes = std::max(peakBytes, bytes());
+
+			// A pass that cut nothing has searched every word
+			if (solutionNode || limitExceeded || nextBound == none) break;
+			bound = nextBound;
+		}
+
+		if (stats) {
+			stats->nodesExpanded = nExpanded;
+			stats->nodesGenerated = nGenerated;
+			stats->bytes = peakBytes;
+			stats->peakFrontier = peakPending;
+			stats->peakVisited = peakVisited;
+		}
+
+		return solutionNode;
+
+	} // of function run
+
+//----------------------------------------------------------------
+
+	// Search every node whose depth plus its bound is at most 'bound'
+	//
+	// Inputs:
+	//		- char initialSymbol: the root of the search
+	//		- unsigned int bound: the most depth plus steps left of a searched node
+	//		- unsigned int& nextBound: where the least value over 'bound' is stored
+	//		- QueryStats* stats: where the cuts of the pruning are counted (nullptr if not needed)
+	//		- const QueryBudget* budget: the limits of the search (nullptr for none)
+	//
+	// Outputs:
+	//		- TreeNode*: the node of the solution (nullptr if there is none in this pass)
+	//
+	TreeNode* IterativeDeepening::pass(char initialSymbol, unsigned int bound,
+		unsigned int& nextBound, QueryStats* stats, const QueryBudget* budget) {
+
+		pathLength = 0;
+		pending = 0;
+		if (table) table->next_pass();
+
+		++nGenerated;
+		if (!enter(std::string_view{ &initialSymbol, 1 }, bound, nextBound, stats, budget))
+			return nullptr;
+
+		// Go down to the next child of the deepest node or back up to its parent
+		while (!solutionNode && pathLength > 0) {
+
+			Frame& top = frames[pathLength - 1];
+			if (top.next == top.nChildren) {
+				--pathLength;
+				continue;
+			}
+
+			--pending;
+			++nGenerated;
+			if (!enter(top.children[top.next++], bound, nextBound, stats, budget))
+				return nullptr;
+		}
+
+		return solutionNode;
+
+	} // of function pass
+
+//----------------------------------------------------------------
+
+	// Put a word on the path and generate its children
+	//
+	// The word is left out if it is over the bound, was already reached in
+	// this pass with fewer steps or is the solution (which stays on the path)
+	//
+	// Inputs:
+	//		- std::string_view word: the word of the node (a child of the deepest node)
+	//		- unsigned int bound: the most depth plus steps left of a searched node
+	//		- unsigned int& nextBound: the least value over 'bound' so far
+	//		- QueryStats* stats: where the cuts of the pruning are counted (nullptr if not needed)
+	//		- const QueryBudget* budget: the limits of the search (nullptr for none)
+	//
+	// Outputs:
+	//		- bool true: the search goes on
+	//		- bool false: the search stopped at a limit
+	//
+	bool IterativeDeepening::enter(std::string_view word, unsigned int bound,
+		unsigned int& nextBound, QueryStats* stats, const QueryBudget* budget) {
+
+		unsigned int depth = pathLength ? frames[pathLength - 1].node.depth + 1 : 0;
+		unsigned int steps = bounds.estimate(word);
+		if (depth + steps > bound) {
+			nextBound = std::min(nextBound, depth + steps);
+			return true;
+		}
+
+		bool isSolution = word == target.word;
+		if (!isSolution && table && table->seen(word, depth)) {
+			count_pruned(stats, PruneRule::duplicate);
+			return true;
+		}
+
+		// Stop before the expansion that would go over a limit
+		if (!isSolution && budget && budget->limited() && budget->exceeded(nExpanded, bytes())) {
+			limitExceeded = true;
+			return false;
+		}
+
+		// The frames never move, so the nodes of the path can point to their parents
+		// ('word' may be a child of the parent frame, which a new frame does not move)
+		if (pathLength == frames.size())
+			frames.emplace_back();
+		Frame& frame = frames[pathLength];
+		TreeNode* parent = pathLength ? &frames[pathLength - 1].node : nullptr;
+		pathBytes -= frame.bytes;
+
+		frame.word.assign(word);
+		frame.node = TreeNode{ parent, frame.word, depth, steps };
+		frame.next = 0;
+		frame.nChildren = 0;
+		++pathLength;
+
+		if (isSolution)
+			solutionNode = &frame.node;
+		else {
+			frame.nChildren = generate_children(&frame.node, target, symbols,
+				maxRuleGenLen, expansion, frame.children, stats);
+			++nExpanded;
+			pending += frame.nChildren;
+			peakPending = std::max(peakPending, pending);
+		}
+
+		frame.bytes = frame.word.capacity() + frame.children.capacity() * sizeof(std::string);
+		for (const std::string& child : frame.children)
+			frame.bytes += child.capacity();
+		pathBytes += frame.bytes;
+
+		return true;
+
+	} // of function enter
+
+//----------------------------------------------------------------
+
+	// Get the memory of the path and the table
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- size_t: the bytes of the frames, their words and the table
+	//
+	size_t IterativeDeepening::bytes() const {
+
+		return frames.size() * sizeof(Frame) + pathBytes + (table ? table->bytes() : 0);
+
+	} // of function bytes
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
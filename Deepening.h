@@ -0,0 +1,156 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Symbols.h"
+#include "Tree.h"
+#include "Stats.h"
+#include "Budget.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The least depth every word was reached at in one pass of the
+	// iterative deepening, in a table whose size never changes
+	//
+	// Every slot keeps a whole word (at most as long as the target, because
+	// longer words are pruned), so a word is never taken for another one. A
+	// word whose slot is taken replaces the word that was there, so the table
+	// may forget words but never answers wrong
+	//
+	class TranspositionTable {
+	public:
+
+		// Create a table of about 'bytes' bytes for words of at most 'maxLength' symbols
+		TranspositionTable(size_t bytes, size_t maxLength);
+
+		// Start a new pass (the words of the older passes are forgotten)
+		void next_pass();
+
+		// Check if a word was reached at 'depth' or less in this pass
+		// and, if it was not, keep it with 'depth'
+		bool seen(std::string_view word, unsigned int depth);
+
+		// Get the number of words kept in this pass
+		size_t size() const { return count; }
+
+		// Get the number of bytes the table uses
+		size_t bytes() const { return slots.size() * sizeof(Slot) + words.size(); }
+
+	private:
+
+		// The words of a slot are in 'words' at slot * maxLength
+		struct Slot {
+			uint32_t pass;		// The pass that wrote it (0 for never)
+			uint32_t depth;		// The least depth of its word in that pass
+			uint32_t length;	// The length of its word
+		};
+
+		size_t maxLength;
+		std::vector<Slot> slots;
+		std::vector<char> words;
+		uint32_t pass;
+		size_t count;
+
+	}; // of class TranspositionTable
+
+//----------------------------------------------------------------
+
+	// The tree search of check_word with memory linear in the depth (IDA*)
+	//
+	// Every pass is a depth-first search that cuts the nodes whose depth plus
+	// the StepBounds of their word is over a bound, and the next pass uses the
+	// least of the cut values. The bound never overestimates, so the first
+	// solution is a shortest derivation, and a pass that cuts nothing has
+	// seen every word the pruning lets through, so the word is rejected. Only
+	// the path from the root and the children of its nodes are kept; the
+	// optional TranspositionTable drops the words already reached in a pass
+	// with fewer steps
+	//
+	class IterativeDeepening {
+	public:
+
+		// Prepare a search for a word with a table of 'tableBytes' bytes (0 for none)
+		IterativeDeepening(const std::string& word, const SymbolTable& symbols,
+			size_t maxRuleGenLen, Expansion expansion, size_t tableBytes);
+
+		// Search from the initial symbol and return the node of the solution
+		// (nullptr if there is none)
+		// If 'stats' is given what all the passes did is stored in it
+		// If 'budget' is given the search stops when it is exceeded
+		// The nodes of the path of the solution live as long as 'this' search
+		TreeNode* run(char initialSymbol, QueryStats* stats = nullptr,
+			const QueryBudget* budget = nullptr);
+
+		// Check if the last run stopped at a limit of its budget
+		bool limit_exceeded() const { return limitExceeded; }
+
+	private:
+
+		// A node of the path with the children that are still to be searched
+		struct Frame {
+			std::string word;
+			TreeNode node;
+			std::vector<std::string> children;
+			size_t nChildren = 0;
+			size_t next = 0;
+			size_t bytes = 0;		// The memory of 'word' and 'children'
+		};
+
+		static constexpr unsigned int none = UINT32_MAX;	// No node was cut
+
+		// Search every node whose depth plus its bound is at most 'bound'
+		// and return the least value over it in 'nextBound'
+		TreeNode* pass(char initialSymbol, unsigned int bound, unsigned int& nextBound,
+			QueryStats* stats, const QueryBudget* budget);
+
+		// Put a word on the path and generate its children if it can be
+		// expanded (false if the search must stop at a limit)
+		bool enter(std::string_view word, unsigned int bound, unsigned int& nextBound,
+			QueryStats* stats, const QueryBudget* budget);
+
+		// Get the memory of the path and the table
+		size_t bytes() const;
+
+		SearchTarget target;
+		const SymbolTable& symbols;
+		size_t maxRuleGenLen;
+		Expansion expansion;
+		StepBounds bounds;
+		std::optional<TranspositionTable> table;
+
+		std::deque<Frame> frames;	// Kept between the passes to reuse their memory
+		size_t pathLength;			// The frames that hold the path
+		size_t pathBytes;			// The memory of all the frames
+		size_t pending;				// The children on the path that are still to be searched
+
+		TreeNode* solutionNode;
+		bool limitExceeded;
+
+		size_t nExpanded;
+		size_t nGenerated;
+		size_t peakPending;
+
+	}; // of class IterativeDeepening
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,241 @@
+
+//----------------------------------------------------------------
+
+#include "Earley.h"
+
+//----------------------------------------------------------------
+
+#include <unordered_set>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Flatten the rules so every (rule, dot) pair gets a dense id
+	//
+	// The rules must not have empty outputs (the constructor of ContextFreeGrammar
+	// has already removed them) so an item never completes in the set it was predicted
+	//
+	// Inputs:
+	//		- char initialSymbol: the initial symbol of the grammar
+	//		- const std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//
+	// Outputs:
+	//
+	EarleyParser::EarleyParser(char initialSymbol,
+		const std::unordered_map<char, std::vector<std::string>>& ruleMap) {
+
+		rulesOf.assign(256, {});
+		nPositions = 0;
+
+		// The rule S' -> S is always the first one
+		rules.push_back({ '\0', std::string{ initialSymbol }, 0 });
+		nPositions += 2;
+
+		for (const auto& pair : ruleMap)
+			for (const std::string& output : pair.second) {
+				rulesOf[static_cast<unsigned char>(pair.first)].push_back(static_cast<uint32_t>(rules.size()));
+				rules.push_back({ pair.first, output, nPositions });
+				nPositions += output.length() + 1;
+			}
+
+	} // of constructor EarleyParser
+
+//----------------------------------------------------------------
+
+	// Read the rules that 'write' stored in a compiled grammar and give
+	// every (rule, dot) pair its id again
+	//
+	// Inputs:
+	//		- BinaryReader& in: the compiled grammar
+	//
+	// Outputs:
+	//
+	EarleyParser::EarleyParser(BinaryReader& in) {
+
+		std::span<const char> lhs = in.get_array<char>();
+		std::span<const uint64_t> ends = in.get_array<uint64_t>();
+		std::string_view outputs = in.get_string();
+		if (lhs.empty() || lhs.size() != ends.size() || lhs[0] != '\0')
+			in.fail();
+
+		rulesOf.assign(256, {});
+		nPositions = 0;
+
+		size_t begin = 0;
+		for (size_t r = 0; r < lhs.size(); ++r) {
+
+			if (ends[r] < begin || ends[r] > outputs.size()) in.fail();
+			if (r)
+				rulesOf[static_cast<unsigned char>(lhs[r])].push_back(static_cast<uint32_t>(r));
+			rules.push_back({ lhs[r], std::string{ outputs.substr(begin, ends[r] - begin) }, nPositions });
+			nPositions += ends[r] - begin + 1;
+			begin = ends[r];
+		}
+
+	} // of constructor EarleyParser
+
+//----------------------------------------------------------------
+
+	// Write the rules to a compiled grammar
+	//
+	// Inputs:
+	//		- BinaryWriter& out: the compiled grammar
+	//
+	// Outputs:
+	//
+	void EarleyParser::write(BinaryWriter& out) const {
+
+		std::vector<char> lhs;
+		std::vector<uint64_t> ends;
+		std::string outputs;
+		for (const Rule& rule : rules) {
+			lhs.push_back(rule.lhs);
+			outputs += rule.rhs;
+			ends.push_back(outputs.size());
+		}
+		out.put_array(lhs);
+		out.put_array(ends);
+		out.put_string(outputs);
+
+	} // of function write
+
+//----------------------------------------------------------------
+
+	// The state of one Earley set while a word is checked
+	struct EarleySet {
+
+		std::vector<EarleyParser::Item> items;
+		std::unordered_set<uint64_t> seen;
+
+		// The items that wait for a symbol to be completed
+		std::unordered_map<char, std::vector<uint32_t>> waiting;
+
+		// The symbols that have already been predicted in this set
+		std::vector<bool> predicted = std::vector<bool>(256, false);
+
+		// Leo's transitive items: the topmost completed item for a symbol
+		// (or nothing if the completion of the symbol is not deterministic)
+		std::unordered_map<char, std::pair<bool, EarleyParser::Item>> leo;
+
+	}; // of struct EarleySet
+
+//----------------------------------------------------------------
+
+	// Check if 'word' can be generated using the Earley algorithm
+	//
+	// When a symbol A completes from set j and exactly one item of j waits for A
+	// with A as its last symbol, the completion of that item is also certain. Leo's
+	// optimization follows this chain once, memoizes its top item and adds only that
+	// item, instead of every item of the chain in every set
+	//
+	// Inputs:
+	//		- const std::string& word: the word to check
+	//
+	// Outputs:
+	//		- bool true: 'word' was accepted
+	//		- bool false: 'word' was NOT accepted
+	//
+	bool EarleyParser::recognize(const std::string& word) const {
+
+		if (rules.empty()) return false;
+
+		size_t n = word.length();
+		std::vector<EarleySet> sets(n + 1);
+
+		// Add an item to a set if it is not already there
+		auto add = [&](size_t set, Item item) {
+			uint64_t key = item.origin * static_cast<uint64_t>(nPositions) + rules[item.rule].position + item.dot;
+			if (!sets[set].seen.insert(key).second) return;
+			sets[set].items.push_back(item);
+			if (item.dot < rules[item.rule].rhs.length())
+				sets[set].waiting[rules[item.rule].rhs[item.dot]].push_back(
+					static_cast<uint32_t>(sets[set].items.size() - 1));
+		};
+
+		// Find the top of the deterministic completion chain for 'symbol' in set 'set'
+		auto leo = [&](auto& self, size_t set, char symbol) -> std::pair<bool, Item> {
+
+			auto memo = sets[set].leo.find(symbol);
+			if (memo != sets[set].leo.end()) return memo->second;
+
+			// Mark the symbol so a cycle of unit rules stops here
+			sets[set].leo[symbol] = { false, Item{} };
+
+			std::pair<bool, Item> result{ false, Item{} };
+			auto waiting = sets[set].waiting.find(symbol);
+			if (waiting != sets[set].waiting.end() && waiting->second.size() == 1) {
+
+				Item item = sets[set].items[waiting->second[0]];
+				if (item.dot + 1 == rules[item.rule].rhs.length()) {
+					result = self(self, item.origin, rules[item.rule].lhs);
+					if (!result.first)
+						result = { true, Item{ item.rule, item.dot + 1, item.origin } };
+				}
+			}
+
+			sets[set].leo[symbol] = result;
+			return result;
+		};
+
+		add(0, Item{ 0, 0, 0 });
+
+		for (size_t i = 0; i <= n; ++i) {
+
+			// The set grows while it is processed
+			for (size_t k = 0; k < sets[i].items.size(); ++k) {
+
+				Item item = sets[i].items[k];
+				const Rule& rule = rules[item.rule];
+
+				if (item.dot < rule.rhs.length()) {
+
+					char next = rule.rhs[item.dot];
+					const std::vector<uint32_t>& nextRules = rulesOf[static_cast<unsigned char>(next)];
+
+					// Predict the rules of a non-terminal symbol
+					if (!nextRules.empty()) {
+						if (!sets[i].predicted[static_cast<unsigned char>(next)]) {
+							sets[i].predicted[static_cast<unsigned char>(next)] = true;
+							for (uint32_t r : nextRules)
+								add(i, Item{ r, 0, static_cast<uint32_t>(i) });
+						}
+					}
+					// Scan a terminal symbol
+					else if (i < n && word[i] == next)
+						add(i + 1, Item{ item.rule, item.dot + 1, item.origin });
+
+					continue;
+				}
+
+				// Complete the items that wait for 'rule.lhs' in the origin set
+				std::pair<bool, Item> top = leo(leo, item.origin, rule.lhs);
+				if (top.first) {
+					add(i, top.second);
+					continue;
+				}
+
+				auto waiting = sets[item.origin].waiting.find(rule.lhs);
+				if (waiting == sets[item.origin].waiting.end()) continue;
+				for (uint32_t index : waiting->second) {
+					Item parent = sets[item.origin].items[index];
+					add(i, Item{ parent.rule, parent.dot + 1, parent.origin });
+				}
+			}
+
+			// No item reached the next set so the rest of the word cannot be matched
+			if (i < n && sets[i + 1].items.empty()) return false;
+		}
+
+		return sets[n].seen.contains(rules[0].position + 1);
+
+	} // of function recognize
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,72 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Binary.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// An Earley recognizer that works directly on the rules of the grammar
+	//
+	// Leo's optimization is used for the completions so right recursive rules
+	// like L -> L S or N -> N N are checked in linear time
+	//
+	class EarleyParser {
+	public:
+
+		// An empty parser that accepts nothing
+		EarleyParser() : nPositions{ 0 } {}
+
+		// Flatten the rules and add the rule S' -> S for the initial symbol
+		EarleyParser(char initialSymbol,
+			const std::unordered_map<char, std::vector<std::string>>& ruleMap);
+
+		// Read the flattened rules from a compiled grammar
+		EarleyParser(BinaryReader& in);
+
+		// Write the flattened rules to a compiled grammar
+		void write(BinaryWriter& out) const;
+
+		// Check if 'word' can be generated from the initial symbol
+		bool recognize(const std::string& word) const;
+
+		struct Rule {
+			char lhs;			// The input of the rule ('\0' for S' -> S)
+			std::string rhs;	// The output of the rule
+			size_t position;	// The id of the item with the dot at the start of the rule
+		};
+
+		struct Item {
+			uint32_t rule;		// The index of the rule in 'rules'
+			uint32_t dot;		// How many symbols of the output have been matched
+			uint32_t origin;	// The set that the rule was predicted in
+		};
+
+	private:
+
+		std::vector<Rule> rules;
+		std::vector<std::vector<uint32_t>> rulesOf;	// [256] the rules of every symbol
+		size_t nPositions;							// The number of (rule, dot) pairs
+
+	}; // of class EarleyParser
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,452 @@
+
+//----------------------------------------------------------------
+
+#include "Forest.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Build the forest of a word
+	//
+	// Inputs:
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//		- char initialSymbol: the root of every derivation
+	//		- const std::vector<std::pair<char, std::string>>& rules: the rules
+	//			of the grammar as they are written (with the empty and the unit rules)
+	//		- const std::string& word: the word
+	//
+	// Outputs:
+	//
+	ParseForest::ParseForest(const SymbolTable& symbols, char initialSymbol,
+		const std::vector<std::pair<char, std::string>>& rules, const std::string& word)
+		: symbols{ symbols }, initialSymbol{ initialSymbol }, word{ word },
+		width{ word.length() + 1 }, rootNode{ none }, isInfinite{ false } {
+
+		// The items of the rules in the order of the ids of their input symbols
+		std::vector<std::vector<const std::pair<char, std::string>*>> rulesOf(symbols.n_non_terminals());
+		for (const auto& rule : rules)
+			rulesOf[symbols.id(rule.first)].push_back(&rule);
+
+		for (size_t a = 0; a < symbols.n_non_terminals(); ++a) {
+			firstRule.push_back(ruleItems.size());
+			for (const auto* rule : rulesOf[a]) {
+				const std::string& output = rule->second;
+				ruleItems.push_back(items.size());
+				ruleInputs.push_back(rule->first);
+				ruleOutputs.push_back(&output);
+				ruleIsEmpty.push_back(output.empty());
+				for (size_t i = 0; i < output.length(); ++i)
+					items.push_back({ output[i], i + 1 == output.length() });
+			}
+		}
+		firstRule.push_back(ruleItems.size());
+
+		fill_chart();
+		if (!yields(initialSymbol, 0, word.length())) {
+			chart.clear();
+			return;
+		}
+
+		// Only the nodes that the root reaches get their families
+		std::vector<uint32_t> pending;
+		rootNode = node_of(initialSymbol, 0, word.length(), pending);
+		while (!pending.empty()) {
+			uint32_t node = pending.back();
+			pending.pop_back();
+			add_families(node, pending);
+		}
+
+		chart = std::vector<char>{};
+		nodeIds = std::unordered_map<size_t, uint32_t>{};
+
+		count_derivations();
+		if (!isInfinite)
+			total = counts[rootNode];
+
+	} // of constructor ParseForest
+
+//----------------------------------------------------------------
+
+	// Fill the chart of the spans every symbol and every item yields
+	//
+	// A span needs the shorter ones and the empty ones at its ends, so the
+	// spans are filled from the empty ones on. Inside a span an item needs the
+	// rest of its output (the items are filled from the last one) and, through
+	// the unit and the empty rules, the symbols of the same span, so a span is
+	// filled again until nothing changes
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void ParseForest::fill_chart() {
+
+		size_t nNonTerms = symbols.n_non_terminals();
+		size_t length = word.length();
+		chart.assign((nNonTerms + items.size()) * width * width, 0);
+
+		for (size_t span = 0; span <= length; ++span)
+			for (size_t i = 0, j = span; j <= length; ++i, ++j)
+				for (bool changed = true; changed;) {
+					changed = false;
+
+					for (size_t t = items.size(); t-- > 0;) {
+						char& entry = chart[((nNonTerms + t) * width + i) * width + j];
+						if (items[t].last || entry) continue;
+						for (size_t k = i; k <= j; ++k)
+							if (yields(items[t].symbol, i, k) && rest_yields(t + 1, k, j)) {
+								entry = 1;
+								changed = true;
+								break;
+							}
+					}
+
+					for (size_t a = 0; a < nNonTerms; ++a) {
+						char& entry = chart[(a * width + i) * width + j];
+						if (entry) continue;
+						for (size_t r = firstRule[a]; r < firstRule[a + 1]; ++r)
+							if (ruleIsEmpty[r] ? i == j : rest_yields(ruleItems[r], i, j)) {
+								entry = 1;
+								changed = true;
+								break;
+							}
+					}
+				}
+
+	} // of function fill_chart
+
+//----------------------------------------------------------------
+
+	// Check if a symbol yields word[i..j)
+	//
+	// Inputs:
+	//		- char symbol: a terminal or non-terminal symbol
+	//		- size_t i: the start of the span
+	//		- size_t j: the end of the span
+	//
+	// Outputs:
+	//		- bool: if it yields the span
+	//
+	bool ParseForest::yields(char symbol, size_t i, size_t j) const {
+
+		if (symbols.is_terminal(symbol))
+			return j == i + 1 && word[i] == symbol;
+		if (!symbols.is_non_terminal(symbol)) return false;
+		return chart[(symbols.id(symbol) * width + i) * width + j];
+
+	} // of function yields
+
+//----------------------------------------------------------------
+
+	// Check if the rest of an output from an item yields word[i..j)
+	//
+	// Inputs:
+	//		- size_t item: the first item of the rest
+	//		- size_t i: the start of the span
+	//		- size_t j: the end of the span
+	//
+	// Outputs:
+	//		- bool: if it yields the span
+	//
+	bool ParseForest::rest_yields(size_t item, size_t i, size_t j) const {
+
+		if (items[item].last)
+			return yields(items[item].symbol, i, j);
+		return chart[((symbols.n_non_terminals() + item) * width + i) * width + j];
+
+	} // of function rest_yields
+
+//----------------------------------------------------------------
+
+	// Get the node of a symbol over word[i..j)
+	//
+	// Inputs:
+	//		- char symbol: a terminal or non-terminal symbol that yields the span
+	//		- size_t i: the start of the span
+	//		- size_t j: the end of the span
+	//		- std::vector<uint32_t>& pending: the nodes whose families are still to be added
+	//
+	// Outputs:
+	//		- uint32_t: the id of the node
+	//
+	uint32_t ParseForest::node_of(char symbol, size_t i, size_t j, std::vector<uint32_t>& pending) {
+
+		size_t entry = symbols.is_terminal(symbol)
+			? symbols.n_non_terminals() + items.size() : symbols.id(symbol);
+		auto [found, added] = nodeIds.try_emplace((entry * width + i) * width + j,
+			static_cast<uint32_t>(forestNodes.size()));
+		if (added) {
+			forestNodes.push_back({ symbol, none, static_cast<uint32_t>(i), static_cast<uint32_t>(j), 0, 0 });
+			pending.push_back(found->second);
+		}
+		return found->second;
+
+	} // of function node_of
+
+//----------------------------------------------------------------
+
+	// Get the node of the rest of an output from an item over word[i..j)
+	// (the node of its symbol if the item is the last one)
+	//
+	// Inputs:
+	//		- size_t item: the first item of the rest
+	//		- size_t i: the start of the span
+	//		- size_t j: the end of the span
+	//		- std::vector<uint32_t>& pending: the nodes whose families are still to be added
+	//
+	// Outputs:
+	//		- uint32_t: the id of the node
+	//
+	uint32_t ParseForest::rest_node_of(size_t item, size_t i, size_t j, std::vector<uint32_t>& pending) {
+
+		if (items[item].last)
+			return node_of(items[item].symbol, i, j, pending);
+
+		auto [found, added] = nodeIds.try_emplace(((symbols.n_non_terminals() + item) * width + i) * width + j,
+			static_cast<uint32_t>(forestNodes.size()));
+		if (added) {
+			forestNodes.push_back({ 0, static_cast<uint32_t>(item),
+				static_cast<uint32_t>(i), static_cast<uint32_t>(j), 0, 0 });
+			pending.push_back(found->second);
+		}
+		return found->second;
+
+	} // of function rest_node_of
+
+//----------------------------------------------------------------
+
+	// Add the families of a node: every rule of a symbol and every split of
+	// the span between the first symbol of the output and the rest of it (an
+	// empty rule has one family without children over an empty span)
+	//
+	// Inputs:
+	//		- uint32_t node: the id of the node
+	//		- std::vector<uint32_t>& pending: the nodes whose families are still to be added
+	//
+	// Outputs:
+	//
+	void ParseForest::add_families(uint32_t node, std::vector<uint32_t>& pending) {
+
+		// A copy, the new nodes may move the vector
+		Node current = forestNodes[node];
+		if (current.item == none && symbols.is_terminal(current.symbol)) return;
+
+		size_t i = current.start;
+		size_t j = current.end;
+		uint32_t first = static_cast<uint32_t>(families.size());
+
+		auto add_splits = [&](uint32_t rule, size_t item) {
+			char symbol = items[item].symbol;
+			if (items[item].last) {
+				if (yields(symbol, i, j))
+					families.push_back({ rule, node_of(symbol, i, j, pending), none });
+				return;
+			}
+			for (size_t k = i; k <= j; ++k)
+				if (yields(symbol, i, k) && rest_yields(item + 1, k, j)) {
+					uint32_t left = node_of(symbol, i, k, pending);
+					uint32_t right = rest_node_of(item + 1, k, j, pending);
+					families.push_back({ rule, left, right });
+				}
+		};
+
+		if (current.item == none) {
+			size_t a = symbols.id(current.symbol);
+			for (size_t r = firstRule[a]; r < firstRule[a + 1]; ++r)
+				if (!ruleIsEmpty[r])
+					add_splits(static_cast<uint32_t>(r), ruleItems[r]);
+				else if (i == j)
+					families.push_back({ static_cast<uint32_t>(r), none, none });
+		}
+		else
+			add_splits(none, current.item);
+
+		forestNodes[node].firstFamily = first;
+		forestNodes[node].nFamilies = static_cast<uint32_t>(families.size()) - first;
+
+	} // of function add_families
+
+//----------------------------------------------------------------
+
+	// Count the derivations of every node: the sum over its families of the
+	// product of the counts of their children
+	//
+	// A depth first search from the root gives every node after its
+	// children. A child that is still on the path of the search closes a
+	// cycle: every node of the forest yields its span, so the cycle can be
+	// repeated any number of times and the word has infinitely many derivations
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void ParseForest::count_derivations() {
+
+		enum class State : uint8_t { unseen, onPath, counted };
+		std::vector<State> states(forestNodes.size(), State::unseen);
+		counts.assign(forestNodes.size(), BigUnsigned{});
+
+		// The nodes of the path with the next child to visit
+		std::vector<std::pair<uint32_t, size_t>> path{ { rootNode, 0 } };
+		states[rootNode] = State::onPath;
+		while (!path.empty()) {
+
+			auto& [node, next] = path.back();
+			std::span<const Family> nodeFamilies = families_of(forestNodes[node]);
+
+			// The children of the families one after the other (left, right)
+			uint32_t child = none;
+			while (child == none && next < 2 * nodeFamilies.size()) {
+				const Family& family = nodeFamilies[next / 2];
+				child = next % 2 ? family.right : family.left;
+				++next;
+			}
+
+			if (child != none) {
+				if (states[child] == State::onPath) {
+					isInfinite = true;
+					return;
+				}
+				if (states[child] == State::unseen) {
+					states[child] = State::onPath;
+					path.push_back({ child, 0 });
+				}
+				continue;
+			}
+
+			// Every child is counted
+			if (forestNodes[node].nFamilies == 0)
+				counts[node] = BigUnsigned{ 1 };
+			else
+				for (const Family& family : nodeFamilies) {
+					if (family.left == none)
+						counts[node] += BigUnsigned{ 1 };
+					else if (family.right == none)
+						counts[node] += counts[family.left];
+					else
+						counts[node] += counts[family.left] * counts[family.right];
+				}
+			states[node] = State::counted;
+			path.pop_back();
+		}
+
+	} // of function count_derivations
+
+//----------------------------------------------------------------
+
+	// Walk the derivations
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- DerivationIterator: the first derivation (the end if there is none
+	//			or there are infinitely many)
+	//
+	ParseForest::DerivationIterator ParseForest::begin() const {
+
+		if (total.is_zero() || isInfinite) return end();
+		return DerivationIterator{ this };
+
+	} // of function begin
+
+//----------------------------------------------------------------
+
+	// Start at the first derivation of a forest
+	//
+	// Inputs:
+	//		- const ParseForest* f: a forest with at least one derivation
+	//
+	// Outputs:
+	//
+	ParseForest::DerivationIterator::DerivationIterator(const ParseForest* f)
+		: forest{ f } {
+
+		build();
+
+	} // of constructor DerivationIterator
+
+//----------------------------------------------------------------
+
+	// Go to the next derivation
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- DerivationIterator&: 'this' iterator (the end after the last derivation)
+	//
+	ParseForest::DerivationIterator& ParseForest::DerivationIterator::operator++() {
+
+		while (!choices.empty() && choices.back().chosen + 1 == choices.back().nFamilies)
+			choices.pop_back();
+
+		if (choices.empty()) {
+			forest = nullptr;
+			derivation.clear();
+			return *this;
+		}
+
+		++choices.back().chosen;
+		build();
+		return *this;
+
+	} // of function operator++
+
+//----------------------------------------------------------------
+
+	// Walk the tree of the choices and write its leftmost derivation
+	//
+	// The nodes are visited in preorder, left to right, so every symbol node
+	// replaces the leftmost non-terminal symbol of the word before it. The
+	// nodes with more than one family take the next choice, or their first
+	// family when there are no more choices
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void ParseForest::DerivationIterator::build() {
+
+		derivation.clear();
+		std::string current(1, forest->initialSymbol);
+		derivation.push_back(current);
+
+		std::vector<uint32_t> stack{ forest->rootNode };
+		size_t nextChoice = 0;
+		while (!stack.empty()) {
+
+			const Node& node = forest->forestNodes[stack.back()];
+			stack.pop_back();
+			if (node.nFamilies == 0) continue;
+
+			uint32_t chosen = 0;
+			if (node.nFamilies > 1) {
+				if (nextChoice == choices.size())
+					choices.push_back({ 0, node.nFamilies });
+				chosen = choices[nextChoice++].chosen;
+			}
+
+			const Family& family = forest->families[node.firstFamily + chosen];
+			if (family.rule != none) {
+				size_t position = 0;
+				while (!forest->symbols.is_non_terminal(current[position]))
+					++position;
+				current.replace(position, 1, *forest->ruleOutputs[family.rule]);
+				derivation.push_back(current.empty() ? std::string{ EMPTYSTRING } : current);
+			}
+
+			if (family.right != none)
+				stack.push_back(family.right);
+			if (family.left != none)
+				stack.push_back(family.left);
+		}
+
+	} // of function build
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,226 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <iterator>
+#include <unordered_map>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Symbols.h"
+#include "BigUnsigned.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Every derivation of a word, shared and packed (an SPPF)
+	//
+	// The forest is built over the rules of the grammar as they are written,
+	// with their empty and unit rules, so every derivation the grammar has is
+	// counted (the normalized rules lose the ones that go through empty and
+	// unit rules). A chart over the spans of the word, the empty spans
+	// included, marks which symbols and which suffixes of the outputs of the
+	// rules (the items, like in WordSampler) yield every span. The forest then
+	// keeps only the nodes the initial symbol reaches: a symbol node for a
+	// symbol and its span and an intermediate node for an item and its span.
+	// Each node has one family for every way to split it into its first
+	// symbol and the rest of the output, so an ambiguous part of the word is
+	// kept once however many derivations share it
+	//
+	// A child can yield the same span as its parent through the unit and the
+	// empty rules, so the spans are filled until nothing changes and the
+	// nodes are counted in the order of a depth first search. If a node can
+	// reach itself the word has a derivation with a cycle of unit or empty
+	// rules and so infinitely many derivations
+	//
+	// Building the forest takes O(items * length^3) time and the chart takes
+	// (non-terminals + items) * length^2 bytes while it is built. The number
+	// of derivations of every node is counted over the families with
+	// BigUnsigned, so the count is exact and polynomial to get even if it is
+	// exponential in the length
+	//
+	class ParseForest {
+	public:
+
+		static constexpr uint32_t none = UINT32_MAX;
+
+		// A symbol or an item that yields word[start..end) (start == end for the empty word)
+		struct Node {
+			char symbol;			// The symbol (0 for an intermediate node)
+			uint32_t item;			// The item of an intermediate node (none for a symbol node)
+			uint32_t start;
+			uint32_t end;
+			uint32_t firstFamily;	// Where its families start
+			uint32_t nFamilies;		// 0 for the terminal symbols
+		};
+
+		// One way to split a node (a packed node)
+		struct Family {
+			uint32_t rule;			// The rule of a symbol node (none for an intermediate node)
+			uint32_t left;			// The node of the first symbol (none for an empty rule)
+			uint32_t right;			// The node of the rest of the output (none if there is no rest)
+		};
+
+		// Walks every derivation of the word one after the other (an input iterator)
+		//
+		// A derivation is a choice of a family at every node of its tree that
+		// has more than one. The choices are counted like an odometer: the last
+		// choice that has another family moves to it and every node after it
+		// takes its first family, so every step takes time linear in the size
+		// of the derivation
+		//
+		class DerivationIterator {
+		public:
+
+			using iterator_category = std::input_iterator_tag;
+			using value_type = std::vector<std::string>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = const value_type&;
+
+			// The end of every forest
+			DerivationIterator() : forest{ nullptr } {}
+
+			// Get the words from the initial symbol to the word (a leftmost derivation)
+			reference operator*() const { return derivation; }
+			pointer operator->() const { return &derivation; }
+
+			// Go to the next derivation
+			DerivationIterator& operator++();
+
+			bool operator==(const DerivationIterator& other) const {
+				return forest == other.forest && choices == other.choices;
+			}
+
+		private:
+
+			friend class ParseForest;
+
+			// A node with more than one family
+			struct Choice {
+				uint32_t chosen;
+				uint32_t nFamilies;
+				bool operator==(const Choice& other) const = default;
+			};
+
+			// Start at the first derivation of a forest that has one
+			explicit DerivationIterator(const ParseForest* f);
+
+			// Walk the tree of 'choices' (the nodes after them take their first family)
+			void build();
+
+			const ParseForest* forest;
+			std::vector<Choice> choices;
+			std::vector<std::string> derivation;
+
+		}; // of class DerivationIterator
+
+		// Build the forest of a word for the rules of a grammar as they are
+		// written (the symbols and the rules must outlive the forest)
+		ParseForest(const SymbolTable& symbols, char initialSymbol,
+			const std::vector<std::pair<char, std::string>>& rules, const std::string& word);
+
+		// Check if the word has infinitely many derivations (a cycle of unit or empty rules)
+		bool infinite() const { return isInfinite; }
+
+		// Get the number of derivations of the word (zero if it is not
+		// generated, meaningless if it has infinitely many)
+		const BigUnsigned& count() const { return total; }
+
+		// Get the node of the initial symbol over the whole word (none if the
+		// word is not generated)
+		uint32_t root() const { return rootNode; }
+
+		// Get the nodes (the root is the first one)
+		const std::vector<Node>& nodes() const { return forestNodes; }
+
+		// Get the families of a node
+		std::span<const Family> families_of(const Node& node) const {
+			return { families.data() + node.firstFamily, node.nFamilies };
+		}
+
+		// Get the number of derivations of a node (none are counted if the
+		// word has infinitely many)
+		const BigUnsigned& count_of(uint32_t node) const { return counts[node]; }
+
+		// Get the input symbol and the output of a rule of a family
+		char rule_input(uint32_t rule) const { return ruleInputs[rule]; }
+		const std::string& rule_output(uint32_t rule) const { return *ruleOutputs[rule]; }
+
+		// Walk the derivations (none if there are infinitely many)
+		DerivationIterator begin() const;
+		DerivationIterator end() const { return DerivationIterator{}; }
+
+	private:
+
+		// The suffix of an output that starts at a position
+		struct Item {
+			char symbol;	// The symbol at the position
+			bool last;		// If it is the last symbol of the output
+		};
+
+		// Fill the chart of the spans every symbol and every item yields
+		void fill_chart();
+
+		// Check if a symbol or the rest of an output from an item yields word[i..j)
+		bool yields(char symbol, size_t i, size_t j) const;
+		bool rest_yields(size_t item, size_t i, size_t j) const;
+
+		// Get the node of a symbol or of the rest of an output from an item
+		// (created and put on 'pending' if it is new)
+		uint32_t node_of(char symbol, size_t i, size_t j, std::vector<uint32_t>& pending);
+		uint32_t rest_node_of(size_t item, size_t i, size_t j, std::vector<uint32_t>& pending);
+
+		// Add the families of a node
+		void add_families(uint32_t node, std::vector<uint32_t>& pending);
+
+		// Count the derivations of every node or find a cycle
+		void count_derivations();
+
+		const SymbolTable& symbols;
+		char initialSymbol;
+		std::string word;
+		size_t width;					// The length of the word plus one
+
+		std::vector<Item> items;				// The items of every rule one after the other
+		std::vector<size_t> ruleItems;			// [rule] its first item
+		std::vector<char> ruleInputs;			// [rule] its input symbol
+		std::vector<const std::string*> ruleOutputs;	// [rule] its output
+		std::vector<size_t> firstRule;			// [non-terminal id] its first rule (with one more at the end)
+		std::vector<bool> ruleIsEmpty;			// [rule] if its output is empty (it has no items)
+
+		// [(non-terminal id or number of non-terminals + item) * width^2 + i * width + j]
+		// if it yields word[i..j) (only the items that are not last)
+		std::vector<char> chart;
+
+		// The nodes by the index of 'chart' (the terminals have the index after
+		// the last item); it and the chart are dropped when the forest is built
+		std::unordered_map<size_t, uint32_t> nodeIds;
+		std::vector<Node> forestNodes;
+		std::vector<Family> families;
+		std::vector<BigUnsigned> counts;		// [node] its derivations
+
+		uint32_t rootNode;
+		BigUnsigned total;
+		bool isInfinite;
+
+	}; // of class ParseForest
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -36,6 +36,13 @@ namespace Grammars {
 		if (eType == ErrorType::fileNotFound)
 			return "File " + filename + " not found\n";
 
+		if (eType == ErrorType::compiledGrammarError)
+			return "File " + filename + " is damaged or was compiled by another version\n";
+
+		if (eType == ErrorType::tooManySymbols)
+			return "Error in file: " + filename + "\nThe rules have too many nullable symbols: " +
+				"there are no unused characters left for the symbols that split their outputs\n";
+
 		std::string msg{ "Error in file: " + filename + "\n" };
 		msg += "Line: " + std::to_string(eLine) + "\n";
 
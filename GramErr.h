@@ -26,7 +26,8 @@ namespace Grammars {
 		enum class ErrorType {
 			fileNotFound, nTermSymbolsError, duplicateTermSymbol,
 			nNonTermSymbolsError, duplicateNonTermSymbol,
-			initialSymbolError, nRulesError, rulesError
+			initialSymbolError, nRulesError, rulesError,
+			compiledGrammarError, tooManySymbols
 		};
 
 		// Construct the error by providing the line and the type
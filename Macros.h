@@ -8,11 +8,9 @@
 #define HEURISTIC
 
 //#define SHOW_RULES
-//#define SHOW_GENERATED
-//#define SHOW_PRUNED
+//#define SHOW_NORMALIZATION
 
 #define SHOW_TIME
-//#define SHOW_DETAILS
 
 //----------------------------------------------------------------
 
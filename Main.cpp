@@ -4,19 +4,18 @@
 #include <iostream>
 #include <filesystem>
 #include <sstream>
+#include <fstream>
+#include <chrono>
 
 //------------------------------------------------------------------------
 
 #include "Macros.h"
 
-#ifdef SHOW_TIME
-#include <chrono>
-#endif // SHOW_TIME
-
 //------------------------------------------------------------------------
 
 #include "ConFreeGr.h"
 #include "GramErr.h"
+#include "Bench.h"
 
 
 //------------------------------------------------------------------------
@@ -166,7 +165,8 @@ void use_grammar(const std::vector<Grammars::ContextFreeGrammar>& grammars) {
 	std::cout << "Choose an grammar to use (1-" << grammars.size() << "):\n";
 	std::cout << "0: Back\n";
 	for (unsigned int i = 0; i < grammars.size(); ++i)
-		std::cout << i + 1 << ": " << (std::string)grammars[i] << '\n';
+		std::cout << i + 1 << ": " << (std::string)grammars[i]
+			<< " (" << grammars[i].engine_name() << ")\n";
 	std::cout << '\n';
 
 	// Get answer
@@ -234,9 +234,332 @@ void use_grammar(const std::vector<Grammars::ContextFreeGrammar>& grammars) {
 
 //------------------------------------------------------------------------
 
-int main()
+// Print how the batch mode is used
+//
+// Inputs:
+//		- const char* program: the name of the executable
+//
+// Outputs:
+//
+void show_usage(const char* program) {
+
+	std::cerr << "Usage: " << program << " <grammar> [words file] [options]\n"
+		<< "Checks one word per line (stdin if no file is given) and prints 1 or 0 for every word\n"
+		<< "(or ? if the tree search of the word went over a limit)\n\n"
+		<< "Options:\n"
+		<< "  -t, --threads <n>       check the words with n threads (0 for one per core, default 1)\n"
+		<< "  -e, --engine <name>     tree, leftmost, astar, astar-leftmost, ida, ida-leftmost,\n"
+		<< "                          cyk, earley or table (default: the grammar's choice)\n"
+		<< "  -b, --batch <n>         words read before they are checked together (default 65536)\n"
+		<< "  -c, --compile <file>    write the compiled grammar to 'file' and exit\n"
+		<< "  -s, --stats             print what the tree search did for all the words to stderr\n"
+		<< "  -d, --derivations       print the number of derivations of every word (or infinite)\n"
+		<< "                          instead of 1 or 0\n"
+		<< "  --max-nodes <n>         the most nodes the tree search of a word expands\n"
+		<< "  --max-bytes <n>         the most memory the tree search of a word uses\n"
+		<< "  --table-bytes <n>       the transposition table of the ida engines (default none)\n"
+		<< "  --delta-nodes           the tree nodes keep their rules instead of their words\n"
+		<< "  --timeout <ms>          the longest time the tree search of a word takes\n\n"
+		<< "Usage: " << program << " --bench [grammars folder] [options]\n"
+		<< "Measures every engine on accepted and rejected words of growing length\n\n"
+		<< "Options:\n"
+		<< "  -o, --output <file>     write the results as JSON to 'file' (default stdout)\n"
+		<< "  --baseline <file>       compare with the results of another build\n"
+		<< "  --threshold <x>         the growth that counts as a regression (default 0.1)\n"
+		<< "  --max-length <n>        the longest words (default 64)\n"
+		<< "  --max-tree-length <n>   the longest words of the tree searches (default 13)\n"
+		<< "  --words <n>             the words of every length (default 20)\n"
+		<< "  --seed <n>              the seed of the random words (default 1)\n";
+}
+
+//------------------------------------------------------------------------
+
+// Run the benchmarks and compare them with a baseline
+//
+// Inputs:
+//		- int argc, char* argv[]: the arguments of the program (argv[1] is --bench)
+//
+// Outputs:
+//		- int: the exit code (0 on success, 2 for wrong arguments, 3 if a case regressed)
+//
+int run_bench(int argc, char* argv[]) {
+
+	Grammars::BenchOptions options;
+	std::string outputFile;
+	std::string baselineFile;
+	double threshold = 0.1;
+	bool folderGiven = false;
+
+	for (int i = 2; i < argc; ++i) {
+
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if ((arg == "-o" || arg == "--output") && hasValue)
+			outputFile = argv[++i];
+		else if (arg == "--baseline" && hasValue)
+			baselineFile = argv[++i];
+		else if (arg == "--threshold" && hasValue)
+			threshold = std::stod(argv[++i]);
+		else if (arg == "--max-length" && hasValue)
+			options.maxLength = std::stoull(argv[++i]);
+		else if (arg == "--max-tree-length" && hasValue)
+			options.maxTreeLength = std::stoull(argv[++i]);
+		else if (arg == "--words" && hasValue)
+			options.wordsPerCase = std::stoull(argv[++i]);
+		else if (arg == "--seed" && hasValue)
+			options.seed = std::stoull(argv[++i]);
+		else if (arg[0] != '-' && !folderGiven) {
+			options.folder = arg;
+			folderGiven = true;
+		}
+		else {
+			show_usage(argv[0]);
+			return 2;
+		}
+	}
+
+	std::vector<Grammars::BenchResult> results = Grammars::run_benchmarks(options, std::cerr);
+
+	if (outputFile.empty())
+		Grammars::write_results(std::cout, results);
+	else {
+		std::ofstream fout{ outputFile };
+		Grammars::write_results(fout, results);
+	}
+
+	if (!baselineFile.empty()) {
+		std::vector<Grammars::BenchResult> baseline = Grammars::read_results(baselineFile);
+		if (Grammars::compare_results(baseline, results, threshold, std::cerr))
+			return 3;
+	}
+
+	return 0;
+
+}
+
+//------------------------------------------------------------------------
+
+// Check a stream of words without the menu
+//
+// The words are read in batches with a big buffer, every batch is checked
+// with check_words (in parallel if asked) and the results of the batch are
+// written at once. A summary of the throughput is printed to stderr at the end
+// With --derivations every word gets its ParseForest and the number of its
+// derivations is printed instead
+//
+// Inputs:
+//		- int argc, char* argv[]: the arguments of the program
+//
+// Outputs:
+//		- int: the exit code (0 on success, 1 for an error, 2 for wrong arguments)
+//
+int run_batch(int argc, char* argv[]) {
+
+	std::string grammarFile;
+	std::string wordsFile;
+	std::string compiledFile;
+	std::string engineName;
+	unsigned int nThreads = 1;
+	size_t batchSize = 65536;
+	bool showStats = false;
+	bool countDerivations = false;
+	bool deltaNodes = false;
+	size_t tableBytes = 0;
+	Grammars::QueryOptions limits;
+	bool limited = false;
+
+	// Read the arguments
+	for (int i = 1; i < argc; ++i) {
+
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if ((arg == "-t" || arg == "--threads") && hasValue)
+			nThreads = static_cast<unsigned int>(std::stoul(argv[++i]));
+		else if ((arg == "-e" || arg == "--engine") && hasValue)
+			engineName = argv[++i];
+		else if ((arg == "-b" || arg == "--batch") && hasValue)
+			batchSize = std::max<size_t>(std::stoull(argv[++i]), 1);
+		else if ((arg == "-c" || arg == "--compile") && hasValue)
+			compiledFile = argv[++i];
+		else if (arg == "-s" || arg == "--stats")
+			showStats = true;
+		else if (arg == "-d" || arg == "--derivations")
+			countDerivations = true;
+		else if (arg == "--max-nodes" && hasValue) {
+			limits.maxExpanded = std::stoull(argv[++i]);
+			limited = true;
+		}
+		else if (arg == "--max-bytes" && hasValue) {
+			limits.maxBytes = std::stoull(argv[++i]);
+			limited = true;
+		}
+		else if (arg == "--table-bytes" && hasValue)
+			tableBytes = std::stoull(argv[++i]);
+		else if (arg == "--delta-nodes")
+			deltaNodes = true;
+		else if (arg == "--timeout" && hasValue) {
+			limits.timeout = std::chrono::milliseconds{ std::stoull(argv[++i]) };
+			limited = true;
+		}
+		else if (arg == "-h" || arg == "--help") {
+			show_usage(argv[0]);
+			return 0;
+		}
+		else if (arg[0] != '-' && grammarFile.empty())
+			grammarFile = arg;
+		else if (arg[0] != '-' && wordsFile.empty())
+			wordsFile = arg;
+		else {
+			show_usage(argv[0]);
+			return 2;
+		}
+	}
+	if (grammarFile.empty()) {
+		show_usage(argv[0]);
+		return 2;
+	}
+
+	Grammars::ContextFreeGrammar grammar{ grammarFile };
+
+	if (!compiledFile.empty()) {
+		grammar.compile(compiledFile);
+		return 0;
+	}
+
+	// Choose the engine
+	using Engine = Grammars::ContextFreeGrammar::Engine;
+	bool isTreeSearch = false;
+	for (const char* name : { "tree", "leftmost", "astar", "astar-leftmost", "ida", "ida-leftmost" })
+		isTreeSearch = isTreeSearch || engineName == name;
+	if (isTreeSearch) {
+		grammar.set_engine(Engine::treeSearch);
+		if (engineName.ends_with("leftmost"))
+			grammar.set_expansion(Grammars::Expansion::leftmost);
+		if (engineName.starts_with("astar"))
+			grammar.set_ordering(Grammars::Ordering::aStar);
+		if (engineName.starts_with("ida"))
+			grammar.set_ordering(Grammars::Ordering::iterativeDeepening);
+	}
+	else if (engineName == "cyk")
+		grammar.set_engine(Engine::cyk);
+	else if (engineName == "earley")
+		grammar.set_engine(Engine::earley);
+	else if (engineName == "table") {
+		if (!grammar.set_engine(Engine::table)) {
+			std::cerr << grammarFile << " has conflicts, it cannot be checked with a table\n";
+			return 1;
+		}
+	}
+	else if (!engineName.empty()) {
+		show_usage(argv[0]);
+		return 2;
+	}
+	grammar.set_transposition_bytes(tableBytes);
+	if (deltaNodes && !grammar.set_node_encoding(Grammars::NodeEncoding::rules)) {
+		std::cerr << grammarFile << " has too many rules for a symbol, its tree nodes must keep their words\n";
+		return 1;
+	}
+
+	// Buffered streams that are not synchronized with C stdio or flushed for every line
+	std::ios::sync_with_stdio(false);
+	std::cin.tie(nullptr);
+
+	std::ifstream fin;
+	std::vector<char> inBuffer(1 << 20);
+	if (!wordsFile.empty()) {
+		fin.rdbuf()->pubsetbuf(inBuffer.data(), inBuffer.size());
+		fin.open(wordsFile);
+		if (!fin) throw Grammars::Errors(wordsFile, 0, Grammars::Errors::ErrorType::fileNotFound);
+	}
+	std::istream& in = wordsFile.empty() ? std::cin : fin;
+
+	size_t nWords = 0;
+	size_t nAccepted = 0;
+	size_t nUnknown = 0;
+	size_t nBytes = 0;
+	Grammars::QueryStats stats;
+	stats.timed = showStats;
+	auto time = std::chrono::steady_clock::now();
+
+	std::vector<std::string> words;
+	std::string line;
+	std::string results;
+	while (in) {
+
+		// Read a batch of words without their spaces (like the menu does)
+		words.clear();
+		while (words.size() < batchSize && std::getline(in, line)) {
+			nBytes += line.size() + 1;
+			std::erase_if(line, [](char ch) { return isspace(static_cast<unsigned char>(ch)); });
+			words.push_back(line);
+		}
+		if (words.empty()) break;
+
+		results.clear();
+		if (countDerivations)
+			for (const std::string& word : words) {
+				std::optional<Grammars::BigUnsigned> count = grammar.count_derivations(word);
+				results += count ? count->to_string() : "infinite";
+				results += '\n';
+				nAccepted += !count || !count->is_zero();
+			}
+		else if (limited) {
+			using Grammars::QueryResult;
+			for (QueryResult result : grammar.query_words(words, limits, nThreads, showStats ? &stats : nullptr)) {
+				results += result == QueryResult::accepted ? "1\n" : result == QueryResult::rejected ? "0\n" : "?\n";
+				nAccepted += result == QueryResult::accepted;
+				nUnknown += result == QueryResult::limitExceeded;
+			}
+		}
+		else
+			for (bool result : grammar.check_words(words, nThreads, showStats ? &stats : nullptr)) {
+				results += result ? "1\n" : "0\n";
+				nAccepted += result;
+			}
+		std::cout.write(results.data(), results.size());
+		nWords += words.size();
+	}
+	std::cout.flush();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time).count();
+	std::cerr << nWords << " words (" << nAccepted << " accepted";
+	if (limited)
+		std::cerr << ", " << nUnknown << " over a limit";
+	std::cerr << ") in " << seconds << " s with "
+		<< (countDerivations ? "parse forests" : grammar.engine_name()) << ": "
+		<< (seconds > 0 ? nWords / seconds : 0) << " words/s, "
+		<< (seconds > 0 ? nBytes / seconds / 1e6 : 0) << " MB/s\n";
+	if (showStats)
+		Grammars::show_stats(std::cerr, stats);
+
+	return 0;
+
+}
+
+//------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
 try {
 
+	// With arguments the words are checked without the menu
+	if (argc > 1) {
+		try {
+			if (std::string{ argv[1] } == "--bench")
+				return run_bench(argc, argv);
+			return run_batch(argc, argv);
+		}
+		catch (const Grammars::Errors& e) {
+			std::cerr << e.what() << '\n';
+			return 1;
+		}
+		catch (const std::exception& e) {
+			std::cerr << e.what() << '\n';
+			return 1;
+		}
+	}
+
 	std::vector<Grammars::ContextFreeGrammar> grammars;
 
 	// Program loop
@@ -0,0 +1,401 @@
+
+//----------------------------------------------------------------
+
+#include "Normalize.h"
+
+//----------------------------------------------------------------
+
+#include <chrono>
+#include <cctype>
+#include <optional>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Find the symbols that can generate the empty string
+	//
+	// Every rule keeps a counter of the symbols of its output that are not known to
+	// be nullable. When a symbol becomes nullable the counters of the rules that use it
+	// are decreased and a rule whose counter reaches 0 makes its input nullable too.
+	// Every occurrence of a symbol is visited once so the time is linear
+	//
+	// Inputs:
+	//		- const std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//
+	// Outputs:
+	//		- std::unordered_set<char>: the nullable symbols
+	//
+	std::unordered_set<char> nullable_symbols(
+		const std::unordered_map<char, std::vector<std::string>>& ruleMap) {
+
+		std::vector<char> inputs;
+		std::vector<size_t> counters;
+		std::vector<std::vector<size_t>> occurrences(256);
+		std::vector<char> worklist;
+		std::unordered_set<char> nullable;
+
+		for (const auto& pair : ruleMap)
+			for (const std::string& output : pair.second) {
+				size_t rule = inputs.size();
+				inputs.push_back(pair.first);
+				counters.push_back(output.length());
+				for (char ch : output)
+					occurrences[static_cast<unsigned char>(ch)].push_back(rule);
+				if (output.empty() && nullable.insert(pair.first).second)
+					worklist.push_back(pair.first);
+			}
+
+		while (!worklist.empty()) {
+			char symbol = worklist.back();
+			worklist.pop_back();
+			for (size_t rule : occurrences[static_cast<unsigned char>(symbol)])
+				if (!--counters[rule] && nullable.insert(inputs[rule]).second)
+					worklist.push_back(inputs[rule]);
+		}
+
+		return nullable;
+
+	} // of function nullable_symbols
+
+//----------------------------------------------------------------
+
+	// Split the outputs with more than two nullable symbols
+	//
+	// An output is cut after its first nullable symbol and a new symbol takes
+	// the rest of it, until every output has at most two nullable symbols (the
+	// new symbol counts as one if the rest is nullable). So remove_empty_rules
+	// adds at most four outputs for every output instead of 2^k, and the time
+	// stays linear in the size of the grammar. The same rest gets the same new
+	// symbol. The new symbols are characters that the grammar does not use,
+	// the printable ones first
+	// Example: with A, B, C nullable, S -> aABC becomes S -> aAN, N -> BC
+	//
+	// Inputs:
+	//		- std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//		- std::unordered_set<char>& nullable: the nullable symbols, the new
+	//			nullable symbols are added to them
+	//		- SymbolTable& symbols: the symbols of the grammar, the new symbols
+	//			are added to them as non-terminal symbols
+	//
+	// Outputs:
+	//		- bool: false if there were not enough unused characters for the new symbols
+	//
+	bool split_nullable_outputs(std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		std::unordered_set<char>& nullable, SymbolTable& symbols) {
+
+		std::vector<char> unused;
+		for (int pass = 0; pass < 2; ++pass)
+			for (int code = 1; code < 256; ++code) {
+				char ch = static_cast<char>(code);
+				if (isprint(code) != (pass == 0) || isspace(code) || ch == EMPTYSTRING[0]) continue;
+				if (symbols.kind(ch) == SymbolTable::Kind::none)
+					unused.push_back(ch);
+			}
+		std::reverse(unused.begin(), unused.end());
+
+		std::unordered_map<std::string, char> restSymbols;
+		std::vector<std::pair<char, std::string>> pending;	// The new symbols with their outputs
+
+		// Cut an output and return the part that stays (or nothing if there are no symbols left)
+		auto split = [&](const std::string& output) -> std::optional<std::string> {
+			size_t nNullable = std::count_if(output.begin(), output.end(),
+				[&](char ch) { return nullable.contains(ch); });
+			if (nNullable <= 2) return output;
+
+			size_t cut = 0;
+			while (!nullable.contains(output[cut]))
+				++cut;
+			std::string rest = output.substr(cut + 1);
+
+			auto [found, added] = restSymbols.try_emplace(rest, 0);
+			if (added) {
+				if (unused.empty()) return std::nullopt;
+				found->second = unused.back();
+				unused.pop_back();
+				symbols.add_non_terminal(found->second);
+				if (nNullable == rest.length() + 1)
+					nullable.insert(found->second);
+				pending.push_back({ found->second, rest });
+			}
+			return output.substr(0, cut + 1) + found->second;
+		};
+
+		for (auto& pair : ruleMap)
+			for (std::string& output : pair.second) {
+				std::optional<std::string> kept = split(output);
+				if (!kept) return false;
+				output = *kept;
+			}
+
+		// The outputs of the new symbols may need to be cut again
+		while (!pending.empty()) {
+			auto [input, output] = pending.back();
+			pending.pop_back();
+			std::optional<std::string> kept = split(output);
+			if (!kept) return false;
+			ruleMap[input].push_back(*kept);
+		}
+
+		return true;
+
+	} // of function split_nullable_outputs
+
+//----------------------------------------------------------------
+
+	// Remove the rules with empty outputs
+	//
+	// For every output all the combinations of keeping or dropping its nullable
+	// symbols are added, so the language stays the same without the empty string
+	// (after split_nullable_outputs an output has at most two nullable symbols,
+	// so at most four combinations)
+	// Example: with A nullable, S -> aAb adds S -> ab
+	//
+	// Inputs:
+	//		- std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//		- const std::unordered_set<char>& nullable: the nullable symbols
+	//
+	// Outputs:
+	//
+	void remove_empty_rules(std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		const std::unordered_set<char>& nullable) {
+
+		for (auto& pair : ruleMap) {
+
+			std::vector<std::string> outputs;
+			std::unordered_set<std::string> seen;
+
+			for (const std::string& output : pair.second) {
+
+				std::vector<size_t> positions;
+				for (size_t i = 0; i < output.length(); ++i)
+					if (nullable.contains(output[i]))
+						positions.push_back(i);
+
+				// Every bit of 'mask' drops one nullable symbol
+				for (size_t mask = 0; mask < (size_t{ 1 } << positions.size()); ++mask) {
+					std::string newOutput;
+					for (size_t i = 0, p = 0; i < output.length(); ++i) {
+						if (p < positions.size() && positions[p] == i) {
+							if (mask & (size_t{ 1 } << p++)) continue;
+						}
+						newOutput += output[i];
+					}
+
+					// Discard the empty outputs and the rules that won't make a difference
+					if (newOutput.empty() || newOutput == std::string{ pair.first }) continue;
+					if (seen.insert(newOutput).second)
+						outputs.push_back(newOutput);
+				}
+			}
+
+			pair.second = outputs;
+		}
+
+		std::erase_if(ruleMap, [](const auto& pair) { return pair.second.empty(); });
+
+	} // of function remove_empty_rules
+
+//----------------------------------------------------------------
+
+	// Replace the rules A -> B with the outputs of B
+	//
+	// The unit closure of every symbol is found with a search over the unit rules and
+	// the symbol gets the outputs of every symbol in its closure that are not units
+	//
+	// Inputs:
+	//		- std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//
+	// Outputs:
+	//
+	void remove_unit_rules(std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		const SymbolTable& symbols) {
+
+		auto isUnit = [&](const std::string& output) {
+			return output.length() == 1 && !symbols.is_terminal(output[0]);
+		};
+
+		std::unordered_map<char, std::vector<std::string>> newRuleMap;
+		for (const auto& pair : ruleMap) {
+
+			std::vector<std::string>& outputs = newRuleMap[pair.first];
+			std::unordered_set<std::string> seen;
+
+			std::vector<char> closure{ pair.first };
+			std::unordered_set<char> inClosure{ pair.first };
+			for (size_t i = 0; i < closure.size(); ++i) {
+				auto rules = ruleMap.find(closure[i]);
+				if (rules == ruleMap.end()) continue;
+
+				for (const std::string& output : rules->second)
+					if (isUnit(output)) {
+						if (inClosure.insert(output[0]).second)
+							closure.push_back(output[0]);
+					}
+					else if (seen.insert(output).second)
+						outputs.push_back(output);
+			}
+		}
+
+		std::erase_if(newRuleMap, [](const auto& pair) { return pair.second.empty(); });
+		ruleMap = std::move(newRuleMap);
+
+	} // of function remove_unit_rules
+
+//----------------------------------------------------------------
+
+	// Convert the rules to Chomsky Normal Form
+	//
+	// The rules must not have empty or unit outputs. Terminals inside long outputs
+	// are replaced by new symbols T -> a and the long outputs are split in pairs
+	// Example: A -> aBC becomes A -> T N, N -> B C, T -> a
+	//
+	// Inputs:
+	//		- char initialSymbol: the initial symbol of the grammar
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//		- const std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//
+	// Outputs:
+	//		- CnfGrammar: the rules in Chomsky Normal Form
+	//
+	CnfGrammar to_cnf(char initialSymbol, const SymbolTable& symbols,
+		const std::unordered_map<char, std::vector<std::string>>& ruleMap) {
+
+		CnfGrammar cnf;
+
+		// Give a dense id to every non-terminal symbol
+		std::vector<int> ids(256, -1);
+		auto idOf = [&](char ch) {
+			int& id = ids[static_cast<unsigned char>(ch)];
+			if (id == -1) id = static_cast<int>(cnf.nNonTerms++);
+			return static_cast<size_t>(id);
+		};
+		cnf.start = idOf(initialSymbol);
+		for (const auto& pair : ruleMap)
+			idOf(pair.first);
+
+		// A symbol T -> a for every terminal that is used inside a long output
+		std::vector<int> termIds(256, -1);
+		auto termIdOf = [&](char ch) {
+			int& id = termIds[static_cast<unsigned char>(ch)];
+			if (id == -1) {
+				id = static_cast<int>(cnf.nNonTerms++);
+				cnf.termRules.push_back({ static_cast<size_t>(id), ch });
+			}
+			return static_cast<size_t>(id);
+		};
+
+		for (const auto& pair : ruleMap) {
+			size_t lhs = idOf(pair.first);
+			for (const std::string& output : pair.second) {
+
+				if (output.length() == 1) {
+					cnf.termRules.push_back({ lhs, output[0] });
+					continue;
+				}
+
+				std::vector<size_t> outputIds;
+				for (char ch : output)
+					outputIds.push_back(symbols.is_terminal(ch) ? termIdOf(ch) : idOf(ch));
+
+				size_t left = lhs;
+				for (size_t i = 0; i + 2 < outputIds.size(); ++i) {
+					size_t next = cnf.nNonTerms++;
+					cnf.binaryRules.push_back({ left, { outputIds[i], next } });
+					left = next;
+				}
+				cnf.binaryRules.push_back({ left, { outputIds[outputIds.size() - 2], outputIds.back() } });
+			}
+		}
+
+		return cnf;
+
+	} // of function to_cnf
+
+//----------------------------------------------------------------
+
+	// Run all the steps of the normalization
+	//
+	// Steps: find the nullable symbols, split the outputs with many nullable
+	// symbols, remove the empty rules, remove the unit rules and, if 'cnf' is
+	// given, build the Chomsky Normal Form
+	//
+	// Inputs:
+	//		- const std::string& filename: the file of the grammar (for the errors)
+	//		- char initialSymbol: the initial symbol of the grammar
+	//		- SymbolTable& symbols: the symbols of the grammar (the symbols that
+	//			split the outputs are added to them)
+	//		- std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar, they are normalized in place
+	//		- bool& acceptsEmpty: set to true if the initial symbol is nullable
+	//		- CnfGrammar* cnf: where to put the Chomsky Normal Form (or nullptr to skip it)
+	//
+	// Outputs:
+	//		- std::vector<NormalizationStep>: the report of every step
+	//
+	std::vector<NormalizationStep> normalize(const std::string& filename, char initialSymbol,
+		SymbolTable& symbols,
+		std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		bool& acceptsEmpty, CnfGrammar* cnf) {
+
+		using namespace std::chrono;
+
+		std::vector<NormalizationStep> report;
+		auto time = steady_clock::now();
+
+		// Measure the grammar and the time since the previous step
+		auto addStep = [&](std::string name, size_t nNonTerms, size_t nRules, size_t size) {
+			auto now = steady_clock::now();
+			report.push_back({ name, duration<double, std::milli>(now - time).count(), nNonTerms, nRules, size });
+			time = steady_clock::now();
+		};
+		auto addRuleMapStep = [&](std::string name) {
+			size_t nRules = 0;
+			size_t size = 0;
+			for (const auto& pair : ruleMap) {
+				nRules += pair.second.size();
+				for (const std::string& output : pair.second)
+					size += output.length();
+			}
+			addStep(name, ruleMap.size(), nRules, size);
+		};
+
+		std::unordered_set<char> nullable = nullable_symbols(ruleMap);
+		acceptsEmpty = nullable.contains(initialSymbol);
+		addRuleMapStep("nullable symbols");
+
+		if (!split_nullable_outputs(ruleMap, nullable, symbols))
+			throw Errors(filename, 0, Errors::ErrorType::tooManySymbols);
+		addRuleMapStep("split outputs");
+
+		remove_empty_rules(ruleMap, nullable);
+		addRuleMapStep("empty rules");
+
+		remove_unit_rules(ruleMap, symbols);
+		addRuleMapStep("unit rules");
+
+		if (cnf) {
+			*cnf = to_cnf(initialSymbol, symbols, ruleMap);
+			addStep("chomsky normal form", cnf->nNonTerms,
+				cnf->termRules.size() + cnf->binaryRules.size(),
+				cnf->termRules.size() + 2 * cnf->binaryRules.size());
+		}
+
+		return report;
+
+	} // of function normalize
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
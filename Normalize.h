@@ -0,0 +1,90 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <unordered_set>
+#include <unordered_map>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Symbols.h"
+#include "GramErr.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// How long a step of the normalization took and how big the grammar became
+	struct NormalizationStep {
+
+		std::string name;		// The name of the step
+		double milliseconds;	// The time the step took
+		size_t nNonTerms;		// The number of non-terminal symbols with rules after the step
+		size_t nRules;			// The number of rules after the step
+		size_t size;			// The total length of the rule outputs after the step
+
+	}; // of struct NormalizationStep
+
+//----------------------------------------------------------------
+
+	// A grammar in Chomsky Normal Form with dense ids for the non-terminal symbols
+	//
+	// The ids of the symbols of the original grammar come first and the symbols
+	// created while splitting the long outputs follow them
+	//
+	struct CnfGrammar {
+
+		CnfGrammar() : nNonTerms{ 0 }, start{ 0 } {}
+
+		size_t nNonTerms;	// The number of non-terminal symbols
+		size_t start;		// The id of the initial symbol
+
+		std::vector<std::pair<size_t, char>> termRules;							// A -> a
+		std::vector<std::pair<size_t, std::pair<size_t, size_t>>> binaryRules;	// A -> B C
+
+	}; // of struct CnfGrammar
+
+//----------------------------------------------------------------
+
+	// Find the symbols that can generate the empty string
+	std::unordered_set<char> nullable_symbols(
+		const std::unordered_map<char, std::vector<std::string>>& ruleMap);
+
+	// Split the outputs with more than two nullable symbols with new symbols
+	// (false if the grammar has no unused characters left for them)
+	bool split_nullable_outputs(std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		std::unordered_set<char>& nullable, SymbolTable& symbols);
+
+	// Remove the rules with empty outputs and add the outputs without the nullable symbols
+	void remove_empty_rules(std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		const std::unordered_set<char>& nullable);
+
+	// Replace the rules A -> B with the outputs of B
+	void remove_unit_rules(std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		const SymbolTable& symbols);
+
+	// Convert rules without empty and unit rules to Chomsky Normal Form
+	CnfGrammar to_cnf(char initialSymbol, const SymbolTable& symbols,
+		const std::unordered_map<char, std::vector<std::string>>& ruleMap);
+
+	// Run all the steps of the normalization and report every step
+	// (the symbols get the new symbols that split the long nullable outputs)
+	std::vector<NormalizationStep> normalize(const std::string& filename, char initialSymbol,
+		SymbolTable& symbols,
+		std::unordered_map<char, std::vector<std::string>>& ruleMap,
+		bool& acceptsEmpty, CnfGrammar* cnf);
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,354 @@
+
+//----------------------------------------------------------------
+
+#include "ParSearch.h"
+
+//----------------------------------------------------------------
+
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Create an empty set
+	//
+	// Inputs:
+	//		- VisitedSet::Mode mode: how the words are kept
+	//		- size_t bloomBits: the bits of the Bloom filters of all the shards (0 for none)
+	//
+	// Outputs:
+	//
+	ConcurrentWordSet::ConcurrentWordSet(VisitedSet::Mode mode, size_t bloomBits) {
+
+		for (Shard& shard : shards)
+			shard.words = VisitedSet{ mode, bloomBits / nShards };
+	}
+
+//----------------------------------------------------------------
+
+	// Check if a word is in the set
+	//
+	// Inputs:
+	//		- std::string_view word: the word to find
+	//
+	// Outputs:
+	//		- bool: if the word is in the set
+	//
+	bool ConcurrentWordSet::contains(std::string_view word) const {
+
+		const Shard& shard = shards[std::hash<std::string_view>{}(word) % nShards];
+		std::lock_guard<std::mutex> guard{ shard.lock };
+		return shard.words.contains(word);
+
+	} // of function contains
+
+//----------------------------------------------------------------
+
+	// Add a word to the set
+	//
+	// Inputs:
+	//		- std::string_view word: the word to add (with VisitedSet::Mode::exact
+	//			it must outlive the set)
+	//
+	// Outputs:
+	//		- bool true: the word was added
+	//		- bool false: the word was already in the set
+	//
+	bool ConcurrentWordSet::insert(std::string_view word) {
+
+		Shard& shard = shards[std::hash<std::string_view>{}(word) % nShards];
+		std::lock_guard<std::mutex> guard{ shard.lock };
+		return shard.words.insert(word);
+
+	} // of function insert
+
+//----------------------------------------------------------------
+
+	// Get the number of bytes the shards use
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- size_t: the bytes of all the shards
+	//
+	size_t ConcurrentWordSet::bytes() const {
+
+		size_t total = 0;
+		for (const Shard& shard : shards) {
+			std::lock_guard<std::mutex> guard{ shard.lock };
+			total += shard.words.bytes();
+		}
+		return total;
+
+	} // of function bytes
+
+//----------------------------------------------------------------
+
+	// Get the number of words in the set
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- size_t: the words of all the shards
+	//
+	size_t ConcurrentWordSet::size() const {
+
+		size_t total = 0;
+		for (const Shard& shard : shards) {
+			std::lock_guard<std::mutex> guard{ shard.lock };
+			total += shard.words.size();
+		}
+		return total;
+
+	} // of function size
+
+//----------------------------------------------------------------
+
+	// Prepare a search for a word
+	//
+	// Inputs:
+	//		- const std::string& word: the word we want to generate
+	//		- const SymbolTable& symbols: the symbols of the grammar with their rules
+	//		- size_t maxRuleGenLen: the longest output of a rule
+	//		- Expansion expansion: which non-terminal symbols are replaced
+	//		- VisitedSet::Mode visitedMode: how the words in the tree are kept
+	//		- size_t bloomBits: the bits of the Bloom filter of the words (0 for none)
+	//
+	// Outputs:
+	//
+	ParallelSearch::ParallelSearch(const std::string& word, const SymbolTable& symbols,
+		size_t maxRuleGenLen, Expansion expansion,
+		VisitedSet::Mode visitedMode, size_t bloomBits)
+		: word{ word }, target{ word, symbols }, symbols{ symbols }, maxRuleGenLen{ maxRuleGenLen }, expansion{ expansion },
+		wordSet{ visitedMode, bloomBits }, pending{ 0 }, keepStats{ false }, budget{ nullptr },
+		nExpanded{ 0 }, arenaBytes{ 0 }, visitedBytes{ 0 }, limitExceeded{ false }, stop{ false }, solution{ nullptr } {}
+
+//----------------------------------------------------------------
+
+	// Search for the word with many threads
+	//
+	// Inputs:
+	//		- char initialSymbol: the symbol of the root node
+	//		- unsigned int nThreads: the number of threads (at least 1)
+	//		- QueryStats* stats: where what the threads did is stored (nullptr if not needed)
+	//		- const QueryBudget* budget: the limits of the search (nullptr for none)
+	//
+	// Outputs:
+	//		- TreeNode*: the node that holds the word (nullptr if it cannot be generated
+	//			or if the search stopped at a limit, see limit_exceeded)
+	//
+	TreeNode* ParallelSearch::run(char initialSymbol, unsigned int nThreads, QueryStats* stats,
+		const QueryBudget* budget) {
+
+		nThreads = std::max(nThreads, 1u);
+		workers.clear();
+		for (unsigned int i = 0; i < nThreads; ++i) {
+			workers.push_back(std::make_unique<Worker>());
+			workers.back()->stats.timed = stats && stats->timed;
+		}
+		keepStats = stats;
+		this->budget = budget && budget->limited() ? budget : nullptr;
+		nExpanded = 0;
+		arenaBytes = 0;
+		visitedBytes = 0;
+		limitExceeded = false;
+
+		// The first thread starts with the root node and the others steal from it
+		Arena& arena = workers[0]->arena;
+		TreeNode* root = arena.make<TreeNode>(nullptr, arena.store(std::string{ initialSymbol }), 0u, 1u);
+		wordSet.insert(root->word);
+		workers[0]->nodes.push_back(root);
+		workers[0]->stats.nodesGenerated = 1;
+		pending = 1;
+
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < nThreads; ++i)
+			threads.emplace_back(&ParallelSearch::work, this, i);
+		work(0);
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		if (stats)
+			fill_stats(*stats);
+
+		return solution.load();
+
+	} // of function run
+
+//----------------------------------------------------------------
+
+	// Add up what the threads of the last run did
+	//
+	// Inputs:
+	//		- QueryStats& stats: where the counters are stored
+	//
+	// Outputs:
+	//
+	void ParallelSearch::fill_stats(QueryStats& stats) const {
+
+		stats.clear();
+		for (const std::unique_ptr<Worker>& worker : workers)
+			stats.add(worker->stats);
+
+		// The threads share the visited set and the frontier peaks are the ones
+		// the threads saw in the count of the pending nodes
+		stats.bytes = wordSet.bytes();
+		for (const std::unique_ptr<Worker>& worker : workers)
+			stats.bytes += worker->arena.bytes_reserved();
+		stats.peakVisited = wordSet.size();
+
+	} // of function fill_stats
+
+//----------------------------------------------------------------
+
+	// Take the newest node of a thread
+	//
+	// Inputs:
+	//		- size_t self: the thread
+	//
+	// Outputs:
+	//		- TreeNode*: the node (nullptr if the deque is empty)
+	//
+	TreeNode* ParallelSearch::pop(size_t self) {
+
+		Worker& worker = *workers[self];
+		std::lock_guard<std::mutex> guard{ worker.lock };
+		if (worker.nodes.empty()) return nullptr;
+
+		TreeNode* node = worker.nodes.back();
+		worker.nodes.pop_back();
+		return node;
+
+	} // of function pop
+
+//----------------------------------------------------------------
+
+	// Take the oldest node of the first other thread that has one
+	//
+	// Inputs:
+	//		- size_t self: the thread that steals
+	//
+	// Outputs:
+	//		- TreeNode*: the node (nullptr if every deque is empty)
+	//
+	TreeNode* ParallelSearch::steal(size_t self) {
+
+		for (size_t i = 1; i < workers.size(); ++i) {
+
+			Worker& victim = *workers[(self + i) % workers.size()];
+			std::lock_guard<std::mutex> guard{ victim.lock };
+			if (victim.nodes.empty()) continue;
+
+			TreeNode* node = victim.nodes.front();
+			victim.nodes.pop_front();
+			return node;
+		}
+		return nullptr;
+
+	} // of function steal
+
+//----------------------------------------------------------------
+
+	// Expand nodes until the word is found or there is no node left
+	//
+	// Inputs:
+	//		- size_t self: the thread
+	//
+	// Outputs:
+	//
+	void ParallelSearch::work(size_t self) {
+
+		Worker& worker = *workers[self];
+		std::vector<std::string> childWords;
+		std::vector<TreeNode*> children;
+
+		while (!stop.load(std::memory_order_relaxed)) {
+
+			TreeNode* node = pop(self);
+			if (!node) node = steal(self);
+			if (!node) {
+
+				// Nothing is left to expand and nothing will be added
+				if (!pending.load()) break;
+
+				std::this_thread::yield();
+				continue;
+			}
+
+			// Stop every thread before an expansion that would go over a limit
+			if (budget && budget->exceeded(nExpanded.fetch_add(1, std::memory_order_relaxed),
+				arenaBytes.load(std::memory_order_relaxed) + visitedBytes.load(std::memory_order_relaxed))) {
+				limitExceeded = true;
+				stop = true;
+				break;
+			}
+			size_t arenaBefore = worker.arena.bytes_reserved();
+
+			QueryStats* stats = keepStats ? &worker.stats : nullptr;
+			size_t nChildren = generate_children(node, target, symbols, maxRuleGenLen,
+				expansion, childWords, stats);
+			++worker.stats.nodesExpanded;
+
+			children.clear();
+			for (size_t i = 0; i < nChildren && !stop.load(std::memory_order_relaxed); ++i) {
+
+				bool seen;
+				{
+					ScopedTimer timer{ stats && stats->timed ? &stats->pruningSeconds : nullptr };
+					seen = wordSet.contains(childWords[i]);
+				}
+				if (seen) {
+					count_pruned(stats, PruneRule::duplicate);
+					continue;
+				}
+
+				TreeNode* child = create_child(node, childWords[i], symbols, worker.arena);
+				if (!wordSet.insert(child->word)) {
+					count_pruned(stats, PruneRule::duplicate);
+					continue;
+				}
+				++worker.stats.nodesGenerated;
+
+				// Stop every thread as soon as the word is generated
+				if (child->word == word) {
+					solution = child;
+					stop = true;
+					break;
+				}
+				children.push_back(child);
+			}
+
+			// The best child (the fewest non-terminal symbols) is pushed last
+			// so it is the next node of this thread
+			std::stable_sort(children.begin(), children.end(),
+				[](const TreeNode* a, const TreeNode* b) { return a->heuristic > b->heuristic; });
+
+			if (budget) {
+				arenaBytes.fetch_add(worker.arena.bytes_reserved() - arenaBefore, std::memory_order_relaxed);
+				if (worker.stats.nodesExpanded % 64 == 0)
+					visitedBytes.store(wordSet.bytes(), std::memory_order_relaxed);
+			}
+
+			size_t nPending = pending += children.size();
+			if (stats)
+				stats->peakFrontier = std::max(stats->peakFrontier, nPending);
+			{
+				std::lock_guard<std::mutex> guard{ worker.lock };
+				worker.nodes.insert(worker.nodes.end(), children.begin(), children.end());
+			}
+			--pending;
+		}
+
+	} // of function work
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,149 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <string_view>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Arena.h"
+#include "Symbols.h"
+#include "Tree.h"
+#include "Visited.h"
+#include "Stats.h"
+#include "Budget.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// A set of words that many threads can use at the same time
+	//
+	// The words are split to shards by their hash and every shard has its own
+	// lock, so two threads only wait for each other when their words fall in
+	// the same shard. Every shard is a VisitedSet of the same mode
+	//
+	class ConcurrentWordSet {
+	public:
+
+		// Create an empty set whose shards share 'bloomBits' bits of Bloom filters
+		ConcurrentWordSet(VisitedSet::Mode mode, size_t bloomBits);
+
+		// Check if a word is in the set
+		bool contains(std::string_view word) const;
+
+		// Add a word to the set (false if it was already there)
+		bool insert(std::string_view word);
+
+		// Get the number of bytes the shards use
+		size_t bytes() const;
+
+		// Get the number of words in the set
+		size_t size() const;
+
+	private:
+
+		static constexpr size_t nShards = 256;
+
+		struct Shard {
+			mutable std::mutex lock;
+			VisitedSet words;
+		};
+
+		std::array<Shard, nShards> shards;
+
+	}; // of class ConcurrentWordSet
+
+//----------------------------------------------------------------
+
+	// The tree search of check_word spread over many threads
+	//
+	// Every thread keeps its nodes in its own deque and arena. A thread expands
+	// the newest node of its deque (so it goes deep like a single search) and,
+	// when its deque is empty, steals the oldest node of another thread, which
+	// is the root of the biggest unexplored subtree. The search stops as soon as
+	// any thread generates the word or when no node is left anywhere
+	//
+	class ParallelSearch {
+	public:
+
+		// Prepare a search for a word
+		ParallelSearch(const std::string& word, const SymbolTable& symbols,
+			size_t maxRuleGenLen, Expansion expansion,
+			VisitedSet::Mode visitedMode, size_t bloomBits);
+
+		// Search from the initial symbol with 'nThreads' threads
+		// and return the node of the solution (nullptr if there is none)
+		// If 'stats' is given what the threads did is added up in it
+		// If 'budget' is given the threads stop when it is exceeded
+		// The nodes live as long as 'this' search
+		TreeNode* run(char initialSymbol, unsigned int nThreads, QueryStats* stats = nullptr,
+			const QueryBudget* budget = nullptr);
+
+		// Check if the last run stopped at a limit of its budget
+		bool limit_exceeded() const { return limitExceeded.load(); }
+
+	private:
+
+		// The nodes of one thread
+		struct Worker {
+			std::mutex lock;
+			std::deque<TreeNode*> nodes;
+			Arena arena;
+			QueryStats stats;		// Only changed by the thread that owns the worker
+		};
+
+		// Add up what the threads of the last run did
+		void fill_stats(QueryStats& stats) const;
+
+		// The loop of a thread
+		void work(size_t self);
+
+		// Take the newest node of a thread
+		TreeNode* pop(size_t self);
+
+		// Take the oldest node of another thread
+		TreeNode* steal(size_t self);
+
+		const std::string& word;
+		SearchTarget target;
+		const SymbolTable& symbols;
+		size_t maxRuleGenLen;
+		Expansion expansion;
+
+		std::vector<std::unique_ptr<Worker>> workers;
+		ConcurrentWordSet wordSet;
+
+		std::atomic<size_t> pending;			// The nodes that are in a deque or being expanded
+		bool keepStats;							// If the threads count the cuts of the pruning
+
+		// What the budget is checked against (the visited set is only measured
+		// every few expansions because it locks every shard)
+		const QueryBudget* budget;
+		std::atomic<size_t> nExpanded;
+		std::atomic<size_t> arenaBytes;
+		std::atomic<size_t> visitedBytes;
+		std::atomic<bool> limitExceeded;
+		std::atomic<bool> stop;
+		std::atomic<TreeNode*> solution;
+
+	}; // of class ParallelSearch
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,438 @@
+
+//----------------------------------------------------------------
+
+#include "Sampler.h"
+
+//----------------------------------------------------------------
+
+#include <cmath>
+#include <utility>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The counts are rescaled before they get bigger than this
+	static constexpr double maxCount = 1e200;
+
+//----------------------------------------------------------------
+
+	// Count the derivations of every symbol and every suffix of every output
+	// for every length up to 'maxLength' and build the cumulative tables
+	//
+	// The normalized rules have no empty and no unit rules, so the symbols of
+	// an output of length m each get at least 1 and at most m - 1 of it and
+	// every count of length m only needs the counts of the shorter lengths
+	//
+	// Inputs:
+	//		- const SymbolTable& symbols: the symbols with the normalized rules
+	//			(they must outlive the sampler)
+	//		- char initialSymbol: the initial symbol
+	//		- size_t maxLength: the longest words that will be drawn
+	//
+	// Outputs:
+	//
+	WordSampler::WordSampler(const SymbolTable& symbols, char initialSymbol, size_t maxLength)
+		: symbols{ symbols }, initialSymbol{ initialSymbol }, maxLength{ maxLength },
+		nSymbols{ symbols.n_non_terminals() + symbols.n_terminals() } {
+
+		auto indexOf = [&](char ch) {
+			return symbols.is_terminal(ch) ? symbols.n_non_terminals() + symbols.id(ch) : symbols.id(ch);
+		};
+
+		// Flatten the rules to items
+		for (size_t a = 0; a < symbols.n_non_terminals(); ++a) {
+			firstRule.push_back(ruleItems.size());
+			for (const std::string& output : symbols.rules_of(symbols.non_terminal(a))) {
+				ruleItems.push_back(items.size());
+				for (size_t i = 0; i < output.length(); ++i)
+					items.push_back({ output[i], i + 1 == output.length() });
+			}
+		}
+		firstRule.push_back(ruleItems.size());
+
+		size_t nRules = ruleItems.size();
+		size_t nItems = items.size();
+		counts.assign((maxLength + 1) * nSymbols, 0);
+		itemCounts.assign((maxLength + 1) * nItems, 0);
+		ruleTables.assign((maxLength + 1) * nRules, 0);
+
+		size_t splitSize = maxLength ? maxLength * (maxLength - 1) / 2 : 0;
+		splitOffsets.assign(nItems, 0);
+		size_t nSplitTables = 0;
+		for (size_t t = 0; t < nItems; ++t)
+			if (!items[t].last)
+				splitOffsets[t] = nSplitTables++ * splitSize;
+		splitTables.assign(nSplitTables * splitSize, 0);
+
+		if (maxLength)
+			for (size_t t = 0; t < symbols.n_terminals(); ++t)
+				count_of(symbols.n_non_terminals() + t, 1) = 1;
+
+		for (size_t m = 1; m <= maxLength; ++m) {
+
+			// The suffixes with two or more symbols: the first symbol gets j
+			double* itemRow = &itemCounts[m * nItems];
+			for (size_t t = 0; t < nItems; ++t) {
+
+				if (items[t].last || m < 2) continue;
+
+				double* table = &splitTables[splitOffsets[t] + (m - 1) * (m - 2) / 2];
+				size_t symbol = indexOf(items[t].symbol);
+				double sum = 0;
+				for (size_t j = 1; j < m; ++j) {
+					sum += count_of(symbol, j) * itemCounts[(m - j) * nItems + t + 1];
+					table[j - 1] = sum;
+				}
+				itemRow[t] = sum;
+			}
+
+			// The non-terminal symbols add up their rules (a rule with one
+			// symbol has a terminal symbol that only has a length of 1)
+			double biggest = 0;
+			for (size_t a = 0; a < symbols.n_non_terminals(); ++a) {
+				double sum = 0;
+				for (size_t r = firstRule[a]; r < firstRule[a + 1]; ++r) {
+					size_t t = ruleItems[r];
+					sum += items[t].last ? count_of(indexOf(items[t].symbol), m) : itemRow[t];
+					ruleTables[m * nRules + r] = sum;
+				}
+				count_of(a, m) = sum;
+				biggest = std::max(biggest, sum);
+			}
+
+			// The suffixes with one symbol
+			for (size_t t = 0; t < nItems; ++t)
+				if (items[t].last)
+					itemRow[t] = count_of(indexOf(items[t].symbol), m);
+
+			if (biggest > maxCount)
+				rescale(std::pow(biggest, 1.0 / m));
+		}
+
+		find_neighbours();
+
+	} // of constructor WordSampler
+
+//----------------------------------------------------------------
+
+	// Divide every count of length m by R^m
+	//
+	// Every derivation of a length is divided by the same number, so the
+	// probabilities of the choices do not change
+	//
+	// Inputs:
+	//		- double r: the number R
+	//
+	// Outputs:
+	//
+	void WordSampler::rescale(double r) {
+
+		size_t nRules = ruleItems.size();
+		size_t nItems = items.size();
+		size_t splitSize = maxLength ? maxLength * (maxLength - 1) / 2 : 0;
+
+		for (size_t m = 1; m <= maxLength; ++m) {
+
+			double factor = std::pow(r, -static_cast<double>(m));
+			for (size_t i = 0; i < nSymbols; ++i)
+				counts[m * nSymbols + i] *= factor;
+			for (size_t i = 0; i < nItems; ++i)
+				itemCounts[m * nItems + i] *= factor;
+			for (size_t i = 0; i < nRules; ++i)
+				ruleTables[m * nRules + i] *= factor;
+
+			for (size_t begin = 0; begin < splitTables.size(); begin += splitSize)
+				for (size_t j = 0; j + 1 < m; ++j)
+					splitTables[begin + (m - 1) * (m - 2) / 2 + j] *= factor;
+		}
+
+	} // of function rescale
+
+//----------------------------------------------------------------
+
+	// Check if the initial symbol generates a word of a length
+	//
+	// Inputs:
+	//		- size_t length: the length (1 to maxLength)
+	//
+	// Outputs:
+	//		- bool: if there is a word
+	//
+	bool WordSampler::has_words(size_t length) const {
+		return length && length <= maxLength && count_of(symbols.id(initialSymbol), length) > 0;
+	}
+
+//----------------------------------------------------------------
+
+	// Pick an index from a cumulative table
+	//
+	// Inputs:
+	//		- const double* cumulative: the cumulative weights
+	//		- size_t n: the number of weights
+	//		- std::mt19937_64& rng: the random numbers
+	//
+	// Outputs:
+	//		- size_t: the index (the ones with zero weight are never picked)
+	//
+	size_t WordSampler::pick(const double* cumulative, size_t n, std::mt19937_64& rng) {
+
+		double x = static_cast<double>(rng() >> 11) * 0x1.0p-53 * cumulative[n - 1];
+		size_t i = std::upper_bound(cumulative, cumulative + n, x) - cumulative;
+		return std::min(i, n - 1);
+
+	} // of function pick
+
+//----------------------------------------------------------------
+
+	// Draw a word of a length
+	//
+	// The symbols are expanded from the left with a stack, so the terminal
+	// symbols come out in the order of the word
+	//
+	// Inputs:
+	//		- size_t length: the length of the word
+	//		- std::mt19937_64& rng: the random numbers
+	//		- std::string& word: where the word is stored
+	//
+	// Outputs:
+	//		- bool: if there is a word of 'length'
+	//
+	bool WordSampler::sample(size_t length, std::mt19937_64& rng, std::string& word) const {
+
+		if (!has_words(length)) return false;
+
+		size_t nRules = ruleItems.size();
+		thread_local std::vector<std::pair<char, size_t>> stack;
+
+		word.clear();
+		stack.clear();
+		stack.push_back({ initialSymbol, length });
+
+		while (!stack.empty()) {
+
+			auto [symbol, m] = stack.back();
+			stack.pop_back();
+
+			if (symbols.is_terminal(symbol)) {
+				word += symbol;
+				continue;
+			}
+
+			size_t a = symbols.id(symbol);
+			size_t r = firstRule[a] + pick(&ruleTables[m * nRules + firstRule[a]], firstRule[a + 1] - firstRule[a], rng);
+
+			// Give every symbol of the output its length (a terminal symbol
+			// only has 1) and put them on the stack the first one last
+			size_t base = stack.size();
+			size_t left = m;
+			size_t t = ruleItems[r];
+			for (; !items[t].last; ++t) {
+				size_t j = symbols.is_terminal(items[t].symbol) ? 1
+					: 1 + pick(&splitTables[splitOffsets[t] + (left - 1) * (left - 2) / 2], left - 1, rng);
+				stack.push_back({ items[t].symbol, j });
+				left -= j;
+			}
+			stack.push_back({ items[t].symbol, left });
+			std::reverse(stack.begin() + base, stack.end());
+		}
+
+		return true;
+
+	} // of function sample
+
+//----------------------------------------------------------------
+
+	// Change a word a little without changing its length
+	//
+	// Inputs:
+	//		- std::string& word: the word to change
+	//		- std::mt19937_64& rng: the random numbers
+	//
+	// Outputs:
+	//
+	void WordSampler::mutate(std::string& word, std::mt19937_64& rng) const {
+
+		if (word.empty()) return;
+
+		size_t i = rng() % word.length();
+		if (word.length() > 1 && rng() % 2) {
+			size_t j = (i + 1) % word.length();
+			if (word[i] != word[j]) {
+				std::swap(word[i], word[j]);
+				return;
+			}
+		}
+
+		// Another terminal symbol at i
+		if (symbols.n_terminals() > 1) {
+			size_t id = symbols.id(word[i]);
+			size_t other = (id + 1 + rng() % (symbols.n_terminals() - 1)) % symbols.n_terminals();
+			word[i] = symbols.terminal(other);
+		}
+
+	} // of function mutate
+
+//----------------------------------------------------------------
+
+	// Change a word so that it is surely not generated
+	//
+	// The positions are tried from a random one on and a position takes a
+	// random terminal symbol among the ones that cannot follow the symbol
+	// before it (or start a word) or cannot be followed by the symbol after
+	// it (or end a word)
+	//
+	// Inputs:
+	//		- std::string& word: the word to change
+	//		- std::mt19937_64& rng: the random numbers
+	//
+	// Outputs:
+	//		- bool: if the word was changed
+	//
+	bool WordSampler::mutate_rejected(std::string& word, std::mt19937_64& rng) const {
+
+		if (word.empty()) return false;
+
+		size_t start = symbols.id(initialSymbol) * setWords;
+		size_t first = rng() % word.length();
+		for (size_t k = 0; k < word.length(); ++k) {
+
+			size_t i = (first + k) % word.length();
+			size_t nChoices = 0;
+			char chosen = 0;
+			for (size_t id = 0; id < symbols.n_terminals(); ++id) {
+
+				char ch = symbols.terminal(id);
+				if (ch == word[i]) continue;
+
+				bool impossible = i == 0
+					? !has_terminal(firstTerminals, start, ch)
+					: !has_terminal(followers, symbols.id(word[i - 1]) * setWords, ch);
+				impossible = impossible || (i + 1 == word.length()
+					? !has_terminal(lastTerminals, start, ch)
+					: !has_terminal(followers, id * setWords, word[i + 1]));
+
+				// Every choice is kept with the same probability
+				if (impossible && rng() % ++nChoices == 0)
+					chosen = ch;
+			}
+
+			if (nChoices) {
+				word[i] = chosen;
+				return true;
+			}
+		}
+
+		return false;
+
+	} // of function mutate_rejected
+
+//----------------------------------------------------------------
+
+	// Find the terminal symbols that can be next to each other in the words
+	//
+	// The first and the last terminal symbols of every non-terminal symbol
+	// are found with a fixed point over the first and the last symbols of its
+	// outputs (the normalized rules have no empty outputs). Two terminal
+	// symbols are next to each other in a word only if some output of a
+	// symbol the initial symbol reaches has two neighbours X Y where the first
+	// can end with one and the second can start with the other
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void WordSampler::find_neighbours() {
+
+		size_t nNonTerms = symbols.n_non_terminals();
+		setWords = (symbols.n_terminals() + 63) / 64;
+		firstTerminals.assign(nNonTerms * setWords, 0);
+		lastTerminals.assign(nNonTerms * setWords, 0);
+		followers.assign(symbols.n_terminals() * setWords, 0);
+
+		// Add the terminal symbols of 'from' (or the symbol if it is a terminal) to a set
+		auto add = [&](uint64_t* set, char from, const std::vector<uint64_t>& sets) {
+			bool changed = false;
+			if (symbols.is_terminal(from)) {
+				uint64_t bit = uint64_t{ 1 } << (symbols.id(from) % 64);
+				changed = !(set[symbols.id(from) / 64] & bit);
+				set[symbols.id(from) / 64] |= bit;
+				return changed;
+			}
+			const uint64_t* other = &sets[symbols.id(from) * setWords];
+			for (size_t w = 0; w < setWords; ++w) {
+				changed = changed || (other[w] & ~set[w]);
+				set[w] |= other[w];
+			}
+			return changed;
+		};
+
+		for (bool changed = true; changed;) {
+			changed = false;
+			for (size_t a = 0; a < nNonTerms; ++a)
+				for (const std::string& output : symbols.rules_of(symbols.non_terminal(a))) {
+					changed = add(&firstTerminals[a * setWords], output.front(), firstTerminals) || changed;
+					changed = add(&lastTerminals[a * setWords], output.back(), lastTerminals) || changed;
+				}
+		}
+
+		std::vector<char> reached{ initialSymbol };
+		std::vector<bool> isReached(nNonTerms, false);
+		isReached[symbols.id(initialSymbol)] = true;
+		for (size_t i = 0; i < reached.size(); ++i)
+			for (const std::string& output : symbols.rules_of(reached[i])) {
+
+				for (char ch : output)
+					if (symbols.is_non_terminal(ch) && !isReached[symbols.id(ch)]) {
+						isReached[symbols.id(ch)] = true;
+						reached.push_back(ch);
+					}
+
+				for (size_t k = 0; k + 1 < output.length(); ++k)
+					for (size_t x = 0; x < symbols.n_terminals(); ++x) {
+						char left = output[k];
+						bool ends = symbols.is_terminal(left)
+							? symbols.id(left) == x
+							: lastTerminals[symbols.id(left) * setWords + x / 64] >> (x % 64) & 1;
+						if (ends)
+							add(&followers[x * setWords], output[k + 1], firstTerminals);
+					}
+			}
+
+	} // of function find_neighbours
+
+//----------------------------------------------------------------
+
+	// Check if a word has neighbouring terminal symbols that no word has
+	//
+	// Inputs:
+	//		- std::string_view word: a word of terminal symbols
+	//
+	// Outputs:
+	//		- bool true: the word is surely not generated
+	//		- bool false: the word may be generated
+	//
+	bool WordSampler::has_impossible_neighbours(std::string_view word) const {
+
+		if (word.empty()) return false;
+		for (char ch : word)
+			if (!symbols.is_terminal(ch)) return true;
+
+		size_t start = symbols.id(initialSymbol) * setWords;
+		if (!has_terminal(firstTerminals, start, word.front()) || !has_terminal(lastTerminals, start, word.back()))
+			return true;
+		for (size_t i = 0; i + 1 < word.length(); ++i)
+			if (!has_terminal(followers, symbols.id(word[i]) * setWords, word[i + 1]))
+				return true;
+		return false;
+
+	} // of function has_impossible_neighbours
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
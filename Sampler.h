@@ -0,0 +1,127 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Symbols.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Draws words of an exact length uniformly at random
+	//
+	// The number of derivations of every symbol and every suffix of every
+	// output for every length up to the longest one is counted once with a
+	// dynamic program over the normalized rules. A word is then drawn top down:
+	// the rule of a symbol and the length of every symbol of the output are
+	// chosen with a binary search in cumulative tables weighted by those counts,
+	// so every derivation of the length is equally likely. For unambiguous
+	// grammars that is every word; for ambiguous ones a word with more
+	// derivations comes up more often
+	//
+	// The counts are doubles that are rescaled by R^length when they grow too
+	// big (every derivation of a length is scaled the same, so the ratios stay
+	// right). The tables need O(rules * maxLength^2) doubles
+	//
+	class WordSampler {
+	public:
+
+		// Count the derivations of the normalized rules up to 'maxLength'
+		WordSampler(const SymbolTable& symbols, char initialSymbol, size_t maxLength);
+
+		// Check if the initial symbol generates a word of 'length' (1 to maxLength)
+		bool has_words(size_t length) const;
+
+		// Draw a word of 'length', false if there is none
+		bool sample(size_t length, std::mt19937_64& rng, std::string& word) const;
+
+		// Change one symbol of a word to another terminal or swap two neighbours
+		// (the result is not checked, it may still be generated by the grammar)
+		void mutate(std::string& word, std::mt19937_64& rng) const;
+
+		// Change one symbol of a word to a terminal symbol that no word has next
+		// to its neighbours, so the result is surely not generated (false if
+		// no symbol of the word can be changed like that, the word is then kept)
+		bool mutate_rejected(std::string& word, std::mt19937_64& rng) const;
+
+		// Check if a word starts or ends with a terminal symbol or has two
+		// neighbouring terminal symbols that no word of the grammar has (true
+		// proves that the word is not generated, false proves nothing)
+		bool has_impossible_neighbours(std::string_view word) const;
+
+		size_t max_length() const { return maxLength; }
+
+	private:
+
+		// The suffix of an output that starts at a position
+		struct Item {
+			char symbol;	// The symbol at the position
+			bool last;		// If it is the last symbol of the output
+		};
+
+		// The counts and the cumulative tables of a length
+		double& count_of(size_t symbolId, size_t length) { return counts[length * nSymbols + symbolId]; }
+		double count_of(size_t symbolId, size_t length) const { return counts[length * nSymbols + symbolId]; }
+
+		// Divide every count of length m by R^m
+		void rescale(double r);
+
+		// Pick an index from a cumulative table with a random number
+		static size_t pick(const double* cumulative, size_t n, std::mt19937_64& rng);
+
+		// Find the terminal symbols that can be next to each other in the words
+		void find_neighbours();
+
+		// Check a bit of a set of terminal symbols
+		bool has_terminal(const std::vector<uint64_t>& set, size_t offset, char ch) const {
+			size_t id = symbols.id(ch);
+			return set[offset + id / 64] >> (id % 64) & 1;
+		}
+
+		const SymbolTable& symbols;
+		char initialSymbol;
+		size_t maxLength;
+		size_t nSymbols;				// The non-terminal ids come first, then the terminal ids
+
+		std::vector<Item> items;		// The items of every rule one after the other
+		std::vector<size_t> ruleItems;	// [rule] its first item
+		std::vector<size_t> firstRule;	// [non-terminal id] its first rule (with one more at the end)
+
+		std::vector<double> counts;		// [length * nSymbols + symbol] the derivations
+		std::vector<double> itemCounts;	// [length * items.size() + item] the derivations of the suffix
+
+		// [non-terminal id][length] the cumulative counts of its rules (in 'ruleTables')
+		std::vector<double> ruleTables;
+		// [item][length] the cumulative counts of the length of the symbol of the item
+		// (only for the items that are not last, the table of length m has m - 1
+		// entries and starts after the ones of the lengths 2 to m - 1)
+		std::vector<double> splitTables;
+		std::vector<size_t> splitOffsets;	// [item] where the tables of the item start
+
+		// Sets of terminal symbols with 'setWords' words of 64 bits
+		size_t setWords;
+		std::vector<uint64_t> firstTerminals;	// [non-terminal id] the first symbols of its words
+		std::vector<uint64_t> lastTerminals;	// [non-terminal id] the last symbols of its words
+		std::vector<uint64_t> followers;		// [terminal id] the symbols that can follow it in a word
+
+	}; // of class WordSampler
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,93 @@
+
+//----------------------------------------------------------------
+
+#include "Stats.h"
+
+//----------------------------------------------------------------
+
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Get the name of a pruning rule
+	//
+	// Inputs:
+	//		- PruneRule rule: the rule
+	//
+	// Outputs:
+	//		- const char*: its name
+	//
+	const char* prune_rule_name(PruneRule rule) {
+
+		switch (rule) {
+		case PruneRule::length: return "length";
+		case PruneRule::duplicate: return "duplicate";
+		case PruneRule::terminalOrder: return "terminal order";
+		case PruneRule::nonTerminalPositions: return "non-terminal positions";
+		case PruneRule::terminalCounts: return "terminal counts";
+		case PruneRule::ruleGeneration: return "rule generation";
+		}
+		return "unknown";
+
+	} // of function prune_rule_name
+
+//----------------------------------------------------------------
+
+	// Add up the counters of another query
+	//
+	// Inputs:
+	//		- const QueryStats& other: the counters to add
+	//
+	// Outputs:
+	//
+	void QueryStats::add(const QueryStats& other) {
+
+		nodesGenerated += other.nodesGenerated;
+		nodesExpanded += other.nodesExpanded;
+		bytes = std::max(bytes, other.bytes);
+		for (size_t i = 0; i < nPruneRules; ++i)
+			pruned[i] += other.pruned[i];
+		peakFrontier = std::max(peakFrontier, other.peakFrontier);
+		peakVisited = std::max(peakVisited, other.peakVisited);
+		generationSeconds += other.generationSeconds;
+		pruningSeconds += other.pruningSeconds;
+
+	} // of function add
+
+//----------------------------------------------------------------
+
+	// Print the counters of one or many queries
+	//
+	// Inputs:
+	//		- std::ostream& out: where they are printed
+	//		- const QueryStats& stats: the counters
+	//
+	// Outputs:
+	//
+	void show_stats(std::ostream& out, const QueryStats& stats) {
+
+		out << "Nodes generated: " << stats.nodesGenerated << '\n'
+			<< "Nodes expanded: " << stats.nodesExpanded << '\n'
+			<< "Peak frontier: " << stats.peakFrontier << '\n'
+			<< "Peak visited: " << stats.peakVisited << '\n'
+			<< "Peak bytes: " << stats.bytes << '\n';
+
+		out << "Pruned by:\n";
+		for (size_t i = 0; i < nPruneRules; ++i)
+			out << "  " << prune_rule_name(static_cast<PruneRule>(i)) << ": " << stats.pruned[i] << '\n';
+
+		if (stats.timed)
+			out << "Generation time: " << stats.generationSeconds * 1e3 << " ms\n"
+				<< "Pruning time: " << stats.pruningSeconds * 1e3 << " ms\n";
+
+	} // of function show_stats
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,120 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The rules that cut the children of the tree search
+	enum class PruneRule {
+		length,					// The child is too long or cannot yield the length of the word
+		duplicate,				// The word of the child is already in the tree
+		terminalOrder,			// The terminal symbols are not found in the word in order
+		nonTerminalPositions,	// Neighbouring non-terminal symbols have expanded too much
+		terminalCounts,			// The child needs more of a terminal symbol than the word has
+		ruleGeneration			// A rule has expanded unnecessarily much
+	};
+
+	inline constexpr size_t nPruneRules = 6;
+
+	// Get the name of a pruning rule (for example "terminal order")
+	const char* prune_rule_name(PruneRule rule);
+
+//----------------------------------------------------------------
+
+	// What a single query did (all zero for the engines that build no tree
+	// and for the results that came from the cache)
+	//
+	// The counters are only kept when a query is given a QueryStats, so the
+	// queries without one pay a null check for every cut. The times need two
+	// clock reads for every complete child and are only measured if 'timed'
+	// is set before the query
+	//
+	struct QueryStats {
+
+		bool timed = false;			// Measure the generation and the pruning times (kept by clear)
+
+		size_t nodesGenerated = 0;	// The nodes added to the tree
+		size_t nodesExpanded = 0;	// The nodes whose children were generated
+		size_t bytes = 0;			// The memory of the nodes, their words and the visited set
+
+		// The cuts of every pruning rule (a cut of the lazy expansion drops
+		// every combination of the substitutions to its right at once but
+		// counts as one)
+		std::array<size_t, nPruneRules> pruned{};
+
+		size_t peakFrontier = 0;	// The most nodes that waited to be expanded at once
+		size_t peakVisited = 0;		// The most words in the visited set
+
+		double generationSeconds = 0;	// The time spent generating the children
+		double pruningSeconds = 0;		// The time of the checks of the complete children and the visited set
+
+		// Get the cuts of a pruning rule
+		size_t& pruned_by(PruneRule rule) { return pruned[static_cast<size_t>(rule)]; }
+		size_t pruned_by(PruneRule rule) const { return pruned[static_cast<size_t>(rule)]; }
+
+		// Zero the counters before a query but keep what was asked for
+		void clear() { *this = QueryStats{ timed }; }
+
+		// Add up the counters of another query (the peaks keep the biggest one)
+		void add(const QueryStats& other);
+
+	}; // of struct QueryStats
+
+//----------------------------------------------------------------
+
+	// Count a cut of a pruning rule if the query keeps stats
+	inline void count_pruned(QueryStats* stats, PruneRule rule) {
+		if (stats) ++stats->pruned_by(rule);
+	}
+
+//----------------------------------------------------------------
+
+	// Add the time from its creation to its destruction to a number of
+	// seconds (nothing is measured if it is given nullptr)
+	class ScopedTimer {
+	public:
+
+		explicit ScopedTimer(double* s)
+			: seconds{ s }, start{ s ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{} } {}
+
+		~ScopedTimer() {
+			if (seconds)
+				*seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+
+		double* seconds;
+		std::chrono::steady_clock::time_point start;
+
+	}; // of class ScopedTimer
+
+//----------------------------------------------------------------
+
+	// Print the counters of one or many queries
+	void show_stats(std::ostream& out, const QueryStats& stats);
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -0,0 +1,397 @@
+
+//----------------------------------------------------------------
+
+#include "Symbols.h"
+
+//----------------------------------------------------------------
+
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Create a table where every character has no kind
+	SymbolTable::SymbolTable() {
+		kinds.fill(Kind::none);
+		ids.fill(0);
+		minYields.fill(1);
+		maxYields.fill(1);
+		symbolHasMinCounts.fill(false);
+		hasMinCounts = false;
+	}
+
+//----------------------------------------------------------------
+
+	// Read the table that 'write' stored in a compiled grammar
+	//
+	// The symbols are added again to get their kinds and ids, the rules and
+	// the results of compute_yields and compute_min_counts are read as they are
+	//
+	// Inputs:
+	//		- BinaryReader& in: the compiled grammar
+	//
+	// Outputs:
+	//
+	SymbolTable::SymbolTable(BinaryReader& in) : SymbolTable() {
+
+		std::span<const char> terms = in.get_array<char>();
+		std::span<const char> nonTerms = in.get_array<char>();
+		if (terms.size() + nonTerms.size() > 256) in.fail();
+		for (char ch : terms) {
+			if (kind(ch) != Kind::none) in.fail();
+			add_terminal(ch);
+		}
+		for (char ch : nonTerms) {
+			if (kind(ch) != Kind::none) in.fail();
+			add_non_terminal(ch);
+		}
+
+		// The outputs of every non-terminal symbol follow each other
+		std::span<const uint64_t> nRules = in.get_array<uint64_t>();
+		std::span<const uint64_t> ends = in.get_array<uint64_t>();
+		std::string_view outputs = in.get_string();
+		if (nRules.size() != nonTerminals.size()) in.fail();
+
+		size_t r = 0;
+		size_t begin = 0;
+		for (size_t i = 0; i < nonTerminals.size(); ++i)
+			for (size_t j = 0; j < nRules[i]; ++j, ++r) {
+				if (r >= ends.size() || ends[r] < begin || ends[r] > outputs.size()) in.fail();
+				std::string_view output = outputs.substr(begin, ends[r] - begin);
+				for (char ch : output)
+					if (kind(ch) == Kind::none) in.fail();
+				rules[i].emplace_back(output);
+				begin = ends[r];
+			}
+
+		std::span<const uint64_t> yields = in.get_array<uint64_t>();
+		if (yields.size() != 256) in.fail();
+		std::copy(yields.begin(), yields.end(), minYields.begin());
+		yields = in.get_array<uint64_t>();
+		if (yields.size() != 256) in.fail();
+		std::copy(yields.begin(), yields.end(), maxYields.begin());
+
+		std::span<const uint64_t> nCounts = in.get_array<uint64_t>();
+		std::span<const uint8_t> countIds = in.get_array<uint8_t>();
+		std::span<const uint32_t> counts = in.get_array<uint32_t>();
+		std::span<const uint8_t> flags = in.get_array<uint8_t>();
+		if (nCounts.size() != 256 || countIds.size() != counts.size() || flags.size() != 256)
+			in.fail();
+
+		size_t next = 0;
+		for (size_t ch = 0; ch < 256; ++ch) {
+			if (nCounts[ch] > counts.size() - next) in.fail();
+			minCounts[ch].clear();
+			for (size_t j = 0; j < nCounts[ch]; ++j, ++next) {
+				if (countIds[next] >= terminals.size()) in.fail();
+				minCounts[ch].push_back({ countIds[next], counts[next] });
+			}
+			symbolHasMinCounts[ch] = flags[ch];
+		}
+		hasMinCounts = in.get<uint8_t>();
+
+	} // of constructor SymbolTable
+
+//----------------------------------------------------------------
+
+	// Write the symbols, the rules and their analysis to a compiled grammar
+	//
+	// Inputs:
+	//		- BinaryWriter& out: the compiled grammar
+	//
+	// Outputs:
+	//
+	void SymbolTable::write(BinaryWriter& out) const {
+
+		out.put_array(terminals);
+		out.put_array(nonTerminals);
+
+		std::vector<uint64_t> nRules;
+		std::vector<uint64_t> ends;
+		std::string outputs;
+		for (const std::vector<std::string>& list : rules) {
+			nRules.push_back(list.size());
+			for (const std::string& output : list) {
+				outputs += output;
+				ends.push_back(outputs.size());
+			}
+		}
+		out.put_array(nRules);
+		out.put_array(ends);
+		out.put_string(outputs);
+
+		out.put_array(std::vector<uint64_t>(minYields.begin(), minYields.end()));
+		out.put_array(std::vector<uint64_t>(maxYields.begin(), maxYields.end()));
+
+		std::vector<uint64_t> nCounts;
+		std::vector<uint8_t> countIds;
+		std::vector<uint32_t> counts;
+		for (const auto& list : minCounts) {
+			nCounts.push_back(list.size());
+			for (const auto& [terminal, count] : list) {
+				countIds.push_back(terminal);
+				counts.push_back(count);
+			}
+		}
+		out.put_array(nCounts);
+		out.put_array(countIds);
+		out.put_array(counts);
+		out.put_array(std::vector<uint8_t>(symbolHasMinCounts.begin(), symbolHasMinCounts.end()));
+		out.put<uint8_t>(hasMinCounts);
+
+	} // of function write
+
+//----------------------------------------------------------------
+
+	// Add a terminal symbol
+	//
+	// Inputs:
+	//		- char ch: the symbol
+	//
+	// Outputs:
+	//
+	void SymbolTable::add_terminal(char ch) {
+
+		kinds[static_cast<unsigned char>(ch)] = Kind::terminal;
+		ids[static_cast<unsigned char>(ch)] = static_cast<uint8_t>(terminals.size());
+		minCounts[static_cast<unsigned char>(ch)] = { { static_cast<uint8_t>(terminals.size()), 1 } };
+		terminals.push_back(ch);
+
+	} // of function add_terminal
+
+//----------------------------------------------------------------
+
+	// Add a non-terminal symbol
+	//
+	// Inputs:
+	//		- char ch: the symbol
+	//
+	// Outputs:
+	//
+	void SymbolTable::add_non_terminal(char ch) {
+
+		kinds[static_cast<unsigned char>(ch)] = Kind::nonTerminal;
+		ids[static_cast<unsigned char>(ch)] = static_cast<uint8_t>(nonTerminals.size());
+		nonTerminals.push_back(ch);
+		rules.emplace_back();
+
+	} // of function add_non_terminal
+
+//----------------------------------------------------------------
+
+	// Store the rules by the id of their input symbol
+	//
+	// Inputs:
+	//		- const std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//
+	// Outputs:
+	//
+	void SymbolTable::set_rules(const std::unordered_map<char, std::vector<std::string>>& ruleMap) {
+
+		for (std::vector<std::string>& outputs : rules)
+			outputs.clear();
+
+		for (const auto& pair : ruleMap)
+			if (is_non_terminal(pair.first))
+				rules[id(pair.first)] = pair.second;
+
+		compute_yields();
+		compute_min_counts();
+
+	} // of function set_rules
+
+//----------------------------------------------------------------
+
+	// Add two yield lengths so that anything added to 'unbounded' stays 'unbounded'
+	static size_t add_yields(size_t a, size_t b) {
+		return a >= SymbolTable::unbounded - b ? SymbolTable::unbounded : a + b;
+	}
+
+//----------------------------------------------------------------
+
+	// Find the least and the greatest yield length of every non-terminal symbol
+	// with fixed points over the rules
+	//
+	// The least yield of a symbol is the smallest sum of the least yields of the
+	// symbols of one of its outputs. It starts at 'unbounded' and only gets
+	// smaller, so it stops changing after a pass over the rules changes nothing.
+	// The symbols that keep 'unbounded' generate no word at all
+	//
+	// The greatest yield only uses the outputs whose symbols all generate words.
+	// It starts at 0 and only gets bigger. Without cycles every value is final
+	// after a pass for every non-terminal symbol, so the symbols that still grow
+	// after that are on a cycle that makes longer and longer words. They become
+	// 'unbounded' and the passes go on until that has spread to every symbol
+	// that uses them
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void SymbolTable::compute_yields() {
+
+		for (char ch : nonTerminals) {
+			minYields[static_cast<unsigned char>(ch)] = unbounded;
+			maxYields[static_cast<unsigned char>(ch)] = 0;
+		}
+
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t i = 0; i < nonTerminals.size(); ++i)
+				for (const std::string& output : rules[i]) {
+
+					size_t sum = 0;
+					for (char ch : output)
+						sum = add_yields(sum, min_yield(ch));
+
+					size_t& least = minYields[static_cast<unsigned char>(nonTerminals[i])];
+					if (sum < least) {
+						least = sum;
+						changed = true;
+					}
+				}
+		}
+
+		changed = true;
+		for (size_t pass = 1; changed; ++pass) {
+			changed = false;
+			for (size_t i = 0; i < nonTerminals.size(); ++i) {
+
+				size_t& greatest = maxYields[static_cast<unsigned char>(nonTerminals[i])];
+				size_t before = greatest;
+
+				for (const std::string& output : rules[i]) {
+
+					bool productive = true;
+					size_t sum = 0;
+					for (char ch : output) {
+						productive = productive && min_yield(ch) != unbounded;
+						sum = add_yields(sum, max_yield(ch));
+					}
+
+					if (productive && sum > greatest)
+						greatest = sum;
+				}
+
+				if (greatest != before) {
+					if (pass > nonTerminals.size())
+						greatest = unbounded;
+					changed = true;
+				}
+			}
+		}
+
+		// A symbol that generates nothing has no greatest yield either
+		for (char ch : nonTerminals)
+			if (min_yield(ch) == unbounded)
+				maxYields[static_cast<unsigned char>(ch)] = 0;
+
+	} // of function compute_yields
+
+//----------------------------------------------------------------
+
+	// Find how many times every terminal symbol is at least in the words that
+	// every non-terminal symbol generates (its Parikh vector) with a fixed point
+	//
+	// Every terminal symbol is counted on its own, so the least counts of a
+	// symbol may come from different derivations. They are still a lower bound
+	// for every word the symbol generates, which is all the pruning needs
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void SymbolTable::compute_min_counts() {
+
+		// Counts that big only come from symbols that generate no word
+		constexpr uint32_t none = UINT32_MAX;
+		const size_t nTerms = terminals.size();
+
+		// counts[non-terminal id * nTerms + terminal id]
+		std::vector<uint32_t> counts(nonTerminals.size() * nTerms, none);
+		std::vector<uint32_t> sums(nTerms);
+
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t i = 0; i < nonTerminals.size(); ++i)
+				for (const std::string& output : rules[i]) {
+
+					std::fill(sums.begin(), sums.end(), 0);
+					for (char ch : output) {
+						for (size_t t = 0; t < nTerms; ++t) {
+							uint32_t count = is_terminal(ch) ? (id(ch) == t)
+								: is_non_terminal(ch) ? counts[id(ch) * nTerms + t] : 0;
+							sums[t] = count >= none - sums[t] ? none : sums[t] + count;
+						}
+					}
+
+					for (size_t t = 0; t < nTerms; ++t)
+						if (sums[t] < counts[i * nTerms + t]) {
+							counts[i * nTerms + t] = sums[t];
+							changed = true;
+						}
+				}
+		}
+
+		// Keep only the terminal symbols that every word of the symbol has
+		std::vector<bool> required(nTerms, false);
+		hasMinCounts = false;
+		for (size_t i = 0; i < nonTerminals.size(); ++i) {
+
+			std::vector<std::pair<uint8_t, uint32_t>>& least =
+				minCounts[static_cast<unsigned char>(nonTerminals[i])];
+			least.clear();
+			for (size_t t = 0; t < nTerms; ++t)
+				if (counts[i * nTerms + t] && counts[i * nTerms + t] != none) {
+					least.push_back({ static_cast<uint8_t>(t), counts[i * nTerms + t] });
+					required[t] = true;
+				}
+			hasMinCounts = hasMinCounts || !least.empty();
+		}
+
+		// The terminal symbols that no non-terminal symbol requires are only
+		// counted when they are in the word itself, which the order of the
+		// terminal symbols already checks
+		for (size_t t = 0; t < nTerms; ++t)
+			if (!required[t])
+				minCounts[static_cast<unsigned char>(terminals[t])].clear();
+			else
+				minCounts[static_cast<unsigned char>(terminals[t])] = { { static_cast<uint8_t>(t), 1 } };
+
+		for (size_t ch = 0; ch < 256; ++ch)
+			symbolHasMinCounts[ch] = !minCounts[ch].empty();
+
+	} // of function compute_min_counts
+
+//----------------------------------------------------------------
+
+	// Count every terminal symbol in a word
+	//
+	// Inputs:
+	//		- std::string_view word: the word
+	//
+	// Outputs:
+	//		- std::vector<uint32_t>: how many times every terminal symbol is in the
+	//			word (by the id of the symbol)
+	//
+	std::vector<uint32_t> SymbolTable::terminal_counts(std::string_view word) const {
+
+		std::vector<uint32_t> counts(terminals.size(), 0);
+		for (char ch : word)
+			if (is_terminal(ch))
+				++counts[id(ch)];
+		return counts;
+
+	} // of function terminal_counts
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
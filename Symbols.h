@@ -0,0 +1,133 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <array>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Binary.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The symbols of a grammar compiled to dense ids
+	//
+	// Every character has a byte that tells its kind and a byte with its id, so
+	// a membership test is a single array lookup instead of a hash. The rules are
+	// stored by the id of their input symbol
+	//
+	class SymbolTable {
+	public:
+
+		// The kind of a character in the grammar
+		enum class Kind : uint8_t { none, terminal, nonTerminal };
+
+		// Create a table without symbols
+		SymbolTable();
+
+		// Read the symbols, the rules and their analysis from a compiled grammar
+		SymbolTable(BinaryReader& in);
+
+		// Write the symbols, the rules and their analysis to a compiled grammar
+		void write(BinaryWriter& out) const;
+
+		// Add a symbol and give it the next id of its kind
+		void add_terminal(char ch);
+		void add_non_terminal(char ch);
+
+		// Store the rules of every non-terminal symbol by its id
+		void set_rules(const std::unordered_map<char, std::vector<std::string>>& ruleMap);
+
+		// The yield length of a symbol that generates arbitrarily long words
+		// (and the least yield length of a symbol that generates no word)
+		static constexpr size_t unbounded = SIZE_MAX;
+
+		// Get the kind of a character
+		Kind kind(char ch) const { return kinds[static_cast<unsigned char>(ch)]; }
+
+		bool is_terminal(char ch) const { return kind(ch) == Kind::terminal; }
+		bool is_non_terminal(char ch) const { return kind(ch) == Kind::nonTerminal; }
+
+		// Check if a non-terminal symbol has at least one rule
+		bool has_rules(char ch) const {
+			return is_non_terminal(ch) && !rules[ids[static_cast<unsigned char>(ch)]].empty();
+		}
+
+		// Get the id of a symbol inside its kind
+		size_t id(char ch) const { return ids[static_cast<unsigned char>(ch)]; }
+
+		// Get the rules of a non-terminal symbol
+		const std::vector<std::string>& rules_of(char ch) const { return rules[id(ch)]; }
+
+		// Get the least and the greatest length of the words of terminal symbols
+		// that a symbol generates (1 for terminal symbols)
+		size_t min_yield(char ch) const { return minYields[static_cast<unsigned char>(ch)]; }
+		size_t max_yield(char ch) const { return maxYields[static_cast<unsigned char>(ch)]; }
+
+		// Get how many times every terminal symbol (by id) is at least in the
+		// words a symbol generates (only the terminal symbols that are there)
+		const std::vector<std::pair<uint8_t, uint32_t>>& min_counts(char ch) const {
+			return minCounts[static_cast<unsigned char>(ch)];
+		}
+
+		// Check if any non-terminal symbol always generates some terminal symbol
+		// (without one the counts only repeat what the order of the terminals shows)
+		bool has_min_counts() const { return hasMinCounts; }
+
+		// Check if a symbol always generates some terminal symbol that is counted
+		bool has_min_counts(char ch) const { return symbolHasMinCounts[static_cast<unsigned char>(ch)]; }
+
+		// Count every terminal symbol (by id) in a word
+		std::vector<uint32_t> terminal_counts(std::string_view word) const;
+
+		// Get the number of symbols of every kind
+		size_t n_terminals() const { return terminals.size(); }
+		size_t n_non_terminals() const { return nonTerminals.size(); }
+
+		// Get a symbol from its id
+		char terminal(size_t id) const { return terminals[id]; }
+		char non_terminal(size_t id) const { return nonTerminals[id]; }
+
+	private:
+
+		// Find the least and the greatest yield length of every symbol
+		void compute_yields();
+
+		// Find the least number of every terminal symbol that every symbol generates
+		void compute_min_counts();
+
+		std::array<Kind, 256> kinds;
+		std::array<uint8_t, 256> ids;
+
+		std::vector<char> terminals;
+		std::vector<char> nonTerminals;
+		std::vector<std::vector<std::string>> rules;	// [non-terminal id]
+
+		std::array<size_t, 256> minYields;
+		std::array<size_t, 256> maxYields;
+
+		std::array<std::vector<std::pair<uint8_t, uint32_t>>, 256> minCounts;
+		std::array<bool, 256> symbolHasMinCounts;
+		bool hasMinCounts;
+
+	}; // of class SymbolTable
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
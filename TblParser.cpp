@@ -0,0 +1,556 @@
+
+//----------------------------------------------------------------
+
+#include "TblParser.h"
+
+//----------------------------------------------------------------
+
+#include <map>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// Analyse the rules and build the table that fits the grammar
+	//
+	// An LL(1) table is tried first because it is smaller. If it has conflicts
+	// (for example because of left recursion) an LALR(1) table is tried. If both
+	// have conflicts the kind stays Kind::none and the grammar needs a general engine
+	//
+	// Inputs:
+	//		- char initialSymbol: the initial symbol of the grammar
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//		- const std::unordered_map<char, std::vector<std::string>>& ruleMap:
+	//			the rules of the grammar
+	//
+	// Outputs:
+	//
+	TableParser::TableParser(char initialSymbol,
+		const SymbolTable& symbols,
+		const std::unordered_map<char, std::vector<std::string>>& ruleMap)
+		: kind{ Kind::none }, start{ initialSymbol } {
+
+		rulesOf.assign(256, {});
+		isNonTerm.assign(256, false);
+		for (int ch = 0; ch < 256; ++ch)
+			isNonTerm[ch] = !symbols.is_terminal(static_cast<char>(ch));
+
+		// The rule S' -> S is always the first one
+		rules.push_back({ nSymbols, std::string{ initialSymbol } });
+		for (const auto& pair : ruleMap)
+			for (const std::string& output : pair.second) {
+				rulesOf[static_cast<unsigned char>(pair.first)].push_back(static_cast<int>(rules.size()));
+				rules.push_back({ static_cast<unsigned char>(pair.first), output });
+			}
+
+		analyse();
+
+		if (build_ll1())
+			kind = Kind::ll1;
+		else if (build_lalr1())
+			kind = Kind::lalr1;
+
+	} // of constructor TableParser
+
+//----------------------------------------------------------------
+
+	// Read the table that 'write' stored in a compiled grammar
+	//
+	// Only what 'recognize' needs is stored, the FIRST and FOLLOW sets are not
+	//
+	// Inputs:
+	//		- BinaryReader& in: the compiled grammar
+	//
+	// Outputs:
+	//
+	TableParser::TableParser(BinaryReader& in) {
+
+		kind = static_cast<Kind>(in.get<uint8_t>());
+		start = in.get<char>();
+
+		std::span<const uint8_t> nonTerms = in.get_array<uint8_t>();
+		std::span<const int> lhs = in.get_array<int>();
+		std::span<const uint64_t> ends = in.get_array<uint64_t>();
+		std::string_view outputs = in.get_string();
+		if (kind > Kind::lalr1 || nonTerms.size() != 256 || lhs.size() != ends.size())
+			in.fail();
+
+		isNonTerm.assign(nonTerms.begin(), nonTerms.end());
+
+		size_t begin = 0;
+		for (size_t r = 0; r < lhs.size(); ++r) {
+			if (ends[r] < begin || ends[r] > outputs.size() || lhs[r] < 0 || lhs[r] > nSymbols)
+				in.fail();
+			rules.push_back({ lhs[r], std::string{ outputs.substr(begin, ends[r] - begin) } });
+			begin = ends[r];
+		}
+
+		std::span<const int> table = in.get_array<int>();
+		llTable.assign(table.begin(), table.end());
+		table = in.get_array<int>();
+		actions.assign(table.begin(), table.end());
+		table = in.get_array<int>();
+		gotos.assign(table.begin(), table.end());
+
+		// Every entry must point to a rule or a state that exists
+		int nRules = static_cast<int>(rules.size());
+		if (kind == Kind::ll1) {
+			if (llTable.size() != 256 * nSymbols) in.fail();
+			for (int r : llTable)
+				if (r < -1 || r >= nRules) in.fail();
+		}
+		if (kind == Kind::lalr1) {
+			size_t nStates = actions.size() / nSymbols;
+			if (!nStates || actions.size() != nStates * nSymbols || gotos.size() != nStates * 256)
+				in.fail();
+			for (int action : actions)
+				if (action != acceptAction && (action > static_cast<int>(nStates)
+					|| (action < 0 && (-action > nRules || rules[-action - 1].lhs >= 256))))
+					in.fail();
+			for (int state : gotos)
+				if (state < -1 || state >= static_cast<int>(nStates)) in.fail();
+		}
+
+	} // of constructor TableParser
+
+//----------------------------------------------------------------
+
+	// Write the table and the rules it needs to a compiled grammar
+	//
+	// Inputs:
+	//		- BinaryWriter& out: the compiled grammar
+	//
+	// Outputs:
+	//
+	void TableParser::write(BinaryWriter& out) const {
+
+		out.put<uint8_t>(static_cast<uint8_t>(kind));
+		out.put<char>(start);
+		out.put_array(std::vector<uint8_t>(isNonTerm.begin(), isNonTerm.end()));
+
+		std::vector<int> lhs;
+		std::vector<uint64_t> ends;
+		std::string outputs;
+		for (const Rule& rule : rules) {
+			lhs.push_back(rule.lhs);
+			outputs += rule.rhs;
+			ends.push_back(outputs.size());
+		}
+		out.put_array(lhs);
+		out.put_array(ends);
+		out.put_string(outputs);
+
+		out.put_array(llTable);
+		out.put_array(actions);
+		out.put_array(gotos);
+
+	} // of function write
+
+//----------------------------------------------------------------
+
+	// Compute the FIRST set of the symbols rhs[from..] and check if they are all nullable
+	//
+	// Inputs:
+	//		- const std::string& rhs: the output of a rule
+	//		- size_t from: the first symbol to use
+	//		- bool& allNullable: set to true if rhs[from..] can generate the empty string
+	//
+	// Outputs:
+	//		- SymbolSet: the terminals that can start rhs[from..]
+	//
+	TableParser::SymbolSet TableParser::first_of(const std::string& rhs, size_t from, bool& allNullable) const {
+
+		SymbolSet result;
+		allNullable = false;
+		for (size_t i = from; i < rhs.length(); ++i) {
+			unsigned char symbol = static_cast<unsigned char>(rhs[i]);
+			if (!isNonTerm[symbol]) {
+				result.set(symbol);
+				return result;
+			}
+			result |= first[symbol];
+			if (!nullable[symbol])
+				return result;
+		}
+		allNullable = true;
+		return result;
+
+	} // of function first_of
+
+//----------------------------------------------------------------
+
+	// Compute the nullable symbols and the FIRST and FOLLOW sets with fixed points
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void TableParser::analyse() {
+
+		nullable.assign(256, false);
+		first.assign(256, SymbolSet{});
+		follow.assign(256, SymbolSet{});
+
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t r = 1; r < rules.size(); ++r) {
+				bool isNullable;
+				SymbolSet f = first_of(rules[r].rhs, 0, isNullable);
+				SymbolSet merged = first[rules[r].lhs] | f;
+				if (merged != first[rules[r].lhs]) {
+					first[rules[r].lhs] = merged;
+					changed = true;
+				}
+				if (isNullable && !nullable[rules[r].lhs]) {
+					nullable[rules[r].lhs] = true;
+					changed = true;
+				}
+			}
+		}
+
+		follow[static_cast<unsigned char>(start)].set(endSymbol);
+		changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t r = 1; r < rules.size(); ++r) {
+				const std::string& rhs = rules[r].rhs;
+				for (size_t i = 0; i < rhs.length(); ++i) {
+					unsigned char symbol = static_cast<unsigned char>(rhs[i]);
+					if (!isNonTerm[symbol]) continue;
+
+					bool restNullable;
+					SymbolSet merged = follow[symbol] | first_of(rhs, i + 1, restNullable);
+					if (restNullable)
+						merged |= follow[rules[r].lhs];
+					if (merged != follow[symbol]) {
+						follow[symbol] = merged;
+						changed = true;
+					}
+				}
+			}
+		}
+
+	} // of function analyse
+
+//----------------------------------------------------------------
+
+	// Build the LL(1) table
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- bool true: the table was built
+	//		- bool false: the grammar has an LL(1) conflict
+	//
+	bool TableParser::build_ll1() {
+
+		llTable.assign(256 * nSymbols, -1);
+
+		for (size_t r = 1; r < rules.size(); ++r) {
+
+			bool isNullable;
+			SymbolSet lookaheads = first_of(rules[r].rhs, 0, isNullable);
+			if (isNullable)
+				lookaheads |= follow[rules[r].lhs];
+
+			for (int t = 0; t < nSymbols; ++t)
+				if (lookaheads[t]) {
+					int& cell = llTable[rules[r].lhs * nSymbols + t];
+					if (cell != -1 && cell != static_cast<int>(r)) {
+						llTable.clear();
+						return false;
+					}
+					cell = static_cast<int>(r);
+				}
+		}
+
+		return true;
+
+	} // of function build_ll1
+
+//----------------------------------------------------------------
+
+	// Build the LALR(1) tables
+	//
+	// The LR(0) automaton is built first and the lookaheads of its kernel items
+	// are propagated through the LR(1) closures until they stop changing
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- bool true: the tables were built
+	//		- bool false: the grammar has a shift/reduce or a reduce/reduce conflict
+	//
+	bool TableParser::build_lalr1() {
+
+		// Give an id to every (rule, dot) pair
+		std::vector<int> posBase(rules.size());
+		std::vector<int> posRule;
+		std::vector<int> posDot;
+		for (size_t r = 0; r < rules.size(); ++r) {
+			posBase[r] = static_cast<int>(posRule.size());
+			for (size_t d = 0; d <= rules[r].rhs.length(); ++d) {
+				posRule.push_back(static_cast<int>(r));
+				posDot.push_back(static_cast<int>(d));
+			}
+		}
+		size_t nPositions = posRule.size();
+
+		auto nextSymbol = [&](int pos) {
+			const std::string& rhs = rules[posRule[pos]].rhs;
+			return static_cast<size_t>(posDot[pos]) < rhs.length() ?
+				static_cast<int>(static_cast<unsigned char>(rhs[posDot[pos]])) : -1;
+		};
+
+		// The LR(0) closure of a kernel
+		std::vector<bool> inClosure(nPositions, false);
+		auto closure = [&](const std::vector<int>& kernel) {
+			std::vector<int> items = kernel;
+			for (int pos : items) inClosure[pos] = true;
+			for (size_t k = 0; k < items.size(); ++k) {
+				int symbol = nextSymbol(items[k]);
+				if (symbol == -1 || !isNonTerm[symbol]) continue;
+				for (int r : rulesOf[symbol])
+					if (!inClosure[posBase[r]]) {
+						inClosure[posBase[r]] = true;
+						items.push_back(posBase[r]);
+					}
+			}
+			for (int pos : items) inClosure[pos] = false;
+			return items;
+		};
+
+		// Build the LR(0) automaton
+		std::vector<std::vector<int>> kernels{ { posBase[0] } };
+		std::map<std::vector<int>, int> stateOf{ { kernels[0], 0 } };
+		std::vector<int> transitions;
+		for (size_t s = 0; s < kernels.size(); ++s) {
+
+			transitions.resize((s + 1) * 256, -1);
+
+			std::map<int, std::vector<int>> next;
+			for (int pos : closure(kernels[s])) {
+				int symbol = nextSymbol(pos);
+				if (symbol != -1)
+					next[symbol].push_back(pos + 1);
+			}
+
+			for (auto& [symbol, kernel] : next) {
+				std::sort(kernel.begin(), kernel.end());
+				auto [it, inserted] = stateOf.insert({ kernel, static_cast<int>(kernels.size()) });
+				if (inserted)
+					kernels.push_back(kernel);
+				transitions[s * 256 + symbol] = it->second;
+			}
+		}
+		size_t nStates = kernels.size();
+
+		// The lookaheads of the kernel items
+		std::vector<std::vector<SymbolSet>> lookaheads(nStates);
+		for (size_t s = 0; s < nStates; ++s)
+			lookaheads[s].assign(kernels[s].size(), SymbolSet{});
+		lookaheads[0][0].set(endSymbol);
+
+		// The LR(1) closure of a state, the lookaheads are left in 'closureLa'
+		std::vector<SymbolSet> closureLa(nPositions);
+		auto closure1 = [&](size_t s) {
+			std::vector<int> items = kernels[s];
+			for (size_t k = 0; k < items.size(); ++k) {
+				closureLa[items[k]] = lookaheads[s][k];
+				inClosure[items[k]] = true;
+			}
+			for (size_t k = 0; k < items.size(); ++k) {
+				int symbol = nextSymbol(items[k]);
+				if (symbol == -1 || !isNonTerm[symbol]) continue;
+
+				bool restNullable;
+				SymbolSet f = first_of(rules[posRule[items[k]]].rhs, posDot[items[k]] + 1, restNullable);
+				if (restNullable)
+					f |= closureLa[items[k]];
+
+				for (int r : rulesOf[symbol]) {
+					int pos = posBase[r];
+					if (!inClosure[pos]) {
+						inClosure[pos] = true;
+						closureLa[pos] = f;
+						items.push_back(pos);
+					}
+					else if ((closureLa[pos] | f) != closureLa[pos]) {
+						closureLa[pos] |= f;
+						// Visit the item again so the new lookaheads reach its own closure
+						items.push_back(pos);
+					}
+				}
+			}
+			std::sort(items.begin(), items.end());
+			items.erase(std::unique(items.begin(), items.end()), items.end());
+			for (int pos : items) inClosure[pos] = false;
+			return items;
+		};
+
+		// Propagate the lookaheads until they stop changing
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t s = 0; s < nStates; ++s)
+				for (int pos : closure1(s)) {
+					int symbol = nextSymbol(pos);
+					if (symbol == -1) continue;
+
+					int target = transitions[s * 256 + symbol];
+					const std::vector<int>& kernel = kernels[target];
+					size_t k = std::lower_bound(kernel.begin(), kernel.end(), pos + 1) - kernel.begin();
+					SymbolSet merged = lookaheads[target][k] | closureLa[pos];
+					if (merged != lookaheads[target][k]) {
+						lookaheads[target][k] = merged;
+						changed = true;
+					}
+				}
+		}
+
+		// Fill the tables
+		actions.assign(nStates * nSymbols, 0);
+		gotos.assign(nStates * 256, -1);
+		auto setAction = [&](size_t s, int t, int action) {
+			int& cell = actions[s * nSymbols + t];
+			if (cell && cell != action) return false;
+			cell = action;
+			return true;
+		};
+
+		for (size_t s = 0; s < nStates; ++s)
+			for (int pos : closure1(s)) {
+				int symbol = nextSymbol(pos);
+
+				if (symbol != -1) {
+					if (isNonTerm[symbol])
+						gotos[s * 256 + symbol] = transitions[s * 256 + symbol];
+					else if (!setAction(s, symbol, transitions[s * 256 + symbol] + 1)) {
+						actions.clear();
+						gotos.clear();
+						return false;
+					}
+					continue;
+				}
+
+				for (int t = 0; t < nSymbols; ++t)
+					if (closureLa[pos][t] && !setAction(s, t, posRule[pos] ? -(posRule[pos] + 1) : acceptAction)) {
+						actions.clear();
+						gotos.clear();
+						return false;
+					}
+			}
+
+		return true;
+
+	} // of function build_lalr1
+
+//----------------------------------------------------------------
+
+	// Check if 'word' can be generated using the table that was built
+	//
+	// Inputs:
+	//		- const std::string& word: the word to check
+	//
+	// Outputs:
+	//		- bool true: 'word' was accepted
+	//		- bool false: 'word' was NOT accepted
+	//
+	bool TableParser::recognize(const std::string& word) const {
+
+		if (kind == Kind::ll1) return recognize_ll1(word);
+		if (kind == Kind::lalr1) return recognize_lalr1(word);
+		return false;
+
+	} // of function recognize
+
+//----------------------------------------------------------------
+
+	// Check 'word' with the LL(1) table by expanding the leftmost symbol of a stack
+	//
+	// Inputs:
+	//		- const std::string& word: the word to check
+	//
+	// Outputs:
+	//		- bool true: 'word' was accepted
+	//		- bool false: 'word' was NOT accepted
+	//
+	bool TableParser::recognize_ll1(const std::string& word) const {
+
+		std::vector<int> stack{ static_cast<unsigned char>(start) };
+		size_t i = 0;
+
+		while (!stack.empty()) {
+
+			int symbol = stack.back();
+			int lookahead = i < word.length() ? static_cast<unsigned char>(word[i]) : endSymbol;
+
+			if (!isNonTerm[symbol]) {
+				if (symbol != lookahead) return false;
+				stack.pop_back();
+				++i;
+				continue;
+			}
+
+			int r = llTable[symbol * nSymbols + lookahead];
+			if (r == -1) return false;
+
+			stack.pop_back();
+			for (auto it = rules[r].rhs.rbegin(); it != rules[r].rhs.rend(); ++it)
+				stack.push_back(static_cast<unsigned char>(*it));
+		}
+
+		return i == word.length();
+
+	} // of function recognize_ll1
+
+//----------------------------------------------------------------
+
+	// Check 'word' with the LALR(1) tables by shifting and reducing on a stack of states
+	//
+	// Inputs:
+	//		- const std::string& word: the word to check
+	//
+	// Outputs:
+	//		- bool true: 'word' was accepted
+	//		- bool false: 'word' was NOT accepted
+	//
+	bool TableParser::recognize_lalr1(const std::string& word) const {
+
+		std::vector<int> stack{ 0 };
+		size_t i = 0;
+
+		while (true) {
+
+			int lookahead = i < word.length() ? static_cast<unsigned char>(word[i]) : endSymbol;
+			int action = actions[stack.back() * nSymbols + lookahead];
+
+			if (!action) return false;
+			if (action == acceptAction) return true;
+
+			// Shift
+			if (action > 0) {
+				stack.push_back(action - 1);
+				++i;
+				continue;
+			}
+
+			// Reduce
+			const Rule& rule = rules[-action - 1];
+			stack.resize(stack.size() - rule.rhs.length());
+			int next = gotos[stack.back() * 256 + rule.lhs];
+			if (next == -1) return false;
+			stack.push_back(next);
+		}
+
+	} // of function recognize_lalr1
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
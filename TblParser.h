@@ -0,0 +1,113 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include <bitset>
+#include <cstdint>
+#include <unordered_map>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+#include "Symbols.h"
+#include "Binary.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// A table-driven parser for deterministic grammars
+	//
+	// The rules are analysed once and an LL(1) table is built if the grammar has
+	// no LL(1) conflicts, otherwise an LALR(1) table if it has no LALR(1) conflicts.
+	// Checking a word with a table needs no backtracking and takes linear time
+	//
+	class TableParser {
+	public:
+
+		// The kind of the table that was built
+		enum class Kind { none, ll1, lalr1 };
+
+		// An empty parser without a table
+		TableParser() : kind{ Kind::none }, start{ 0 } {}
+
+		// Analyse the rules and build an LL(1) or an LALR(1) table
+		TableParser(char initialSymbol,
+			const SymbolTable& symbols,
+			const std::unordered_map<char, std::vector<std::string>>& ruleMap);
+
+		// Read the table from a compiled grammar
+		TableParser(BinaryReader& in);
+
+		// Write the table and the rules it needs to a compiled grammar
+		void write(BinaryWriter& out) const;
+
+		// Get the kind of the table that was built
+		Kind get_kind() const { return kind; }
+
+		// Check if 'word' can be generated using the table
+		bool recognize(const std::string& word) const;
+
+	private:
+
+		// The symbols are the characters (0-255), the end of the word and S'
+		static constexpr int endSymbol = 256;
+		static constexpr int nSymbols = 257;
+
+		using SymbolSet = std::bitset<nSymbols>;
+
+		struct Rule {
+			int lhs;			// The input of the rule (nSymbols for S' -> S)
+			std::string rhs;	// The output of the rule
+		};
+
+		// Compute the nullable symbols and the FIRST and FOLLOW sets
+		void analyse();
+
+		// FIRST of rhs[from..] and whether rhs[from..] is nullable
+		SymbolSet first_of(const std::string& rhs, size_t from, bool& allNullable) const;
+
+		// Try to build the LL(1) table, false if there is a conflict
+		bool build_ll1();
+
+		// Try to build the LALR(1) tables, false if there is a conflict
+		bool build_lalr1();
+
+		// Check a word with the LL(1) or the LALR(1) table
+		bool recognize_ll1(const std::string& word) const;
+		bool recognize_lalr1(const std::string& word) const;
+
+		Kind kind;
+		char start;
+
+		std::vector<Rule> rules;
+		std::vector<std::vector<int>> rulesOf;		// [256] the rules of every symbol
+		std::vector<bool> isNonTerm;				// [256]
+
+		std::vector<bool> nullable;					// [256]
+		std::vector<SymbolSet> first;				// [256]
+		std::vector<SymbolSet> follow;				// [256]
+
+		// LL(1): [symbol * nSymbols + lookahead] the rule to use or -1
+		std::vector<int> llTable;
+
+		// LALR(1): [state * nSymbols + lookahead] 0 for an error, s + 1 to shift
+		// to state s, -(r + 1) to reduce with rule r and 'acceptAction' to accept
+		std::vector<int> actions;
+		std::vector<int> gotos;						// [state * 256 + symbol]
+		static constexpr int acceptAction = INT32_MAX;
+
+	}; // of class TableParser
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
@@ -5,6 +5,12 @@
 
 //----------------------------------------------------------------
 
+#include <new>
+#include <chrono>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
 namespace Grammars {
 
 //----------------------------------------------------------------
@@ -28,18 +34,15 @@ namespace Grammars {
 		TreeNode* current_node = (*frontierHead)->n;
 
 		// Remove the extracted node from the frontier
+		// (its memory belongs to the Arena of the query)
 
 		// If the frontier has only one node
 		if (*frontierHead == *frontierTail) {
-			delete *frontierHead;
 			*frontierHead = nullptr;
 			*frontierTail = nullptr;
 		}
-		else {
-			FrontierNode* temp_node = (*frontierHead)->next;
-			delete *frontierHead;
-			*frontierHead = temp_node;
-		}
+		else
+			*frontierHead = (*frontierHead)->next;
 
 		return current_node;
 	}
@@ -52,13 +55,15 @@ namespace Grammars {
 	//		- FrontierNode* frontierHead: the head of the frontier that the child will be added
 	//		- FrontierNode* frontierTail: the tail of the frontier that the child will be added
 	//		- TreeNode* child: the child that will be added to the fronteir
+	//		- Arena& arena: the arena of the query
 	//
 	// Outputs:
 	//
-	void add_to_back(FrontierNode** frontierHead, FrontierNode** frontierTail, TreeNode* child) {
+	void add_to_back(FrontierNode** frontierHead, FrontierNode** frontierTail, TreeNode* child,
+		Arena& arena) {
 
 		// Construct the new node
-		FrontierNode* node = new FrontierNode(child);
+		FrontierNode* node = arena.make<FrontierNode>(child);
 
 		// If the frontier is empty
 		if (!*frontierHead) { 
@@ -73,54 +78,71 @@ namespace Grammars {
 
 //----------------------------------------------------------------
 
-	// Add in order the new child to the frontier depending on the heuristic score
-	// and the depth of the node in the tree
+	// Add a node to the bucket of two keys
 	//
 	// Inputs:
-	//		- FrontierNode* frontierHead: the head of the frontier that the child will be added
-	//		- FrontierNode* frontierTail: the tail of the frontier that the child will be added
-	//		- TreeNode* child: the child that will be added to the frontier
+	//		- TreeNode* node: the node that will be added to the frontier
+	//		- size_t primary: the first key (the heuristic score by default)
+	//		- size_t secondary: the key between the nodes of the same first key (the depth by default)
 	//
 	// Outputs:
 	//
-	void add_in_order(FrontierNode** frontierHead, FrontierNode** frontierTail, TreeNode* child) {
-		
-		// Construct the new node
-		FrontierNode* node = new FrontierNode(child);
+	void BucketFrontier::push(TreeNode* node, size_t primary, size_t secondary) {
 
-		// If the frontier is empty
-		if (!*frontierHead) {
-			*frontierHead = node;
-			*frontierTail = node;
+		size_t heuristic = primary;
+		size_t depth = secondary;
+
+		if (heuristic >= buckets.size()) {
+			buckets.resize(heuristic + 1);
+			bucketCounts.resize(heuristic + 1, 0);
+			minDepths.resize(heuristic + 1, SIZE_MAX);
 		}
-		else {
+		if (depth >= buckets[heuristic].size())
+			buckets[heuristic].resize(depth + 1);
+
+		buckets[heuristic][depth].push_back(node);
+		++bucketCounts[heuristic];
+		++count;
+
+		// Less is better for both heuristic score and depth of the node
+		if (heuristic < minHeuristic || count == 1)
+			minHeuristic = heuristic;
+		if (depth < minDepths[heuristic])
+			minDepths[heuristic] = depth;
+	}
 
-			FrontierNode* temp = *frontierHead;
-			FrontierNode* previous = nullptr;
-
-			// Less is better for both heuristic score and depth of the node
-			while (temp) {
-				if (temp->n->heuristic > node->n->heuristic ||
-					(temp->n->heuristic == node->n->heuristic &&
-						temp->n->depth >= node->n->depth)) {
-					if(!previous) {
-						node->next = *frontierHead;
-						*frontierHead = node;
-						return;
-					}
-					else {
-						node->next = previous->next;
-						previous->next = node;
-						return;
-					}
-				}
-				previous = temp;
-				temp = temp->next;
-			}
+//----------------------------------------------------------------
 
-			previous->next = node;
-			*frontierTail = node;
-		}
+	// Remove the node with the smallest heuristic score and, between them,
+	// the smallest depth
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- TreeNode*: the node (nullptr if the frontier is empty)
+	//
+	TreeNode* BucketFrontier::pop() {
+
+		if (!count) return nullptr;
+
+		while (!bucketCounts[minHeuristic])
+			++minHeuristic;
+
+		std::vector<std::vector<TreeNode*>>& depths = buckets[minHeuristic];
+		size_t& minDepth = minDepths[minHeuristic];
+		while (depths[minDepth].empty())
+			++minDepth;
+
+		TreeNode* node = depths[minDepth].back();
+		depths[minDepth].pop_back();
+		--bucketCounts[minHeuristic];
+		--count;
+
+		// An empty score has no smallest depth until a node is added again
+		if (!bucketCounts[minHeuristic])
+			minDepth = SIZE_MAX;
+
+		return node;
 	}
 
 //----------------------------------------------------------------
@@ -129,16 +151,15 @@ namespace Grammars {
 	//
 	// Inputs:
 	//		- const std::string& word: The word that we need to generate
-	//		- const std::string& childWord: The current generated word
-	//		- const std::unordered_set<char>& terminalSymbols: A map containing
-	//			all the terminal symbols
+	//		- std::string_view childWord: The current generated word
+	//		- const SymbolTable& symbols: the symbols of the grammar
 	//
 	// Outputs:
 	//		- bool true: the child needs pruning
 	//		- bool false: the child does NOT need pruning
 	//
-	bool check_terminal_symbols(const std::string& word, const std::string& childWord,
-		const std::unordered_set<char>& terminalSymbols) {
+	bool check_terminal_symbols(const std::string& word, std::string_view childWord,
+		const SymbolTable& symbols) {
 
 		
 		// Check if all terminals are the same in 'word' and 'childWord'
@@ -146,7 +167,7 @@ namespace Grammars {
 		long long wordBegin = 0;
 		long long childWordBegin = 0;
 		for (; childWordBegin < childWord.length(); ++childWordBegin, ++wordBegin) {
-			if (!terminalSymbols.contains(childWord[childWordBegin]))
+			if (!symbols.is_terminal(childWord[childWordBegin]))
 				break;
 
 			if (childWord[childWordBegin] != word[wordBegin])
@@ -156,7 +177,7 @@ namespace Grammars {
 		long long wordEnd = word.length() - 1;
 		long long childWordEnd = childWord.length() - 1;
 		for (; childWordEnd >= 0; --childWordEnd, --wordEnd) {
-			if (!terminalSymbols.contains(childWord[childWordEnd]))
+			if (!symbols.is_terminal(childWord[childWordEnd]))
 				break;
 
 			if (childWord[childWordEnd] != word[wordEnd])
@@ -167,7 +188,7 @@ namespace Grammars {
 		// terminal symbols
 		std::string onlyTerms;
 		for (long long i = childWordBegin; i <= childWordEnd; ++i)
-			if (terminalSymbols.contains(childWord[i]))
+			if (symbols.is_terminal(childWord[i]))
 				onlyTerms.push_back(childWord[i]);
 
 		if (onlyTerms.empty()) return false;
@@ -192,15 +213,15 @@ namespace Grammars {
 	// is in the right order
 	// Inputs:
 	//		- const std::string& word: the word we want to generate
-	//		- const std::string& childWord: the current generated word
-	//		- const std::unordered_set<char>& nonTerminalSymbols: the non-terminal symbols of the grammar
+	//		- std::string_view childWord: the current generated word
+	//		- const SymbolTable& symbols: the symbols of the grammar
 	// 
 	// Outputs:
 	//		- bool true: the child needs pruning
 	//		- bool false: the child does NOT need pruning
 	//
-	bool check_non_terminal_positions(const std::string& word, const std::string& childWord,
-		const std::unordered_set<char>& nonTerminalSymbols) {
+	bool check_non_terminal_positions(const std::string& word, std::string_view childWord,
+		const SymbolTable& symbols) {
 
 		if (childWord.length() < 2) return false;
 
@@ -208,12 +229,12 @@ namespace Grammars {
 		for (int i = 0; i < childWord.length(); ++i) {
 
 			// If the current symbol is a non-terminal
-			if (nonTerminalSymbols.contains(childWord[i])) {
+			if (symbols.is_non_terminal(childWord[i])) {
 
 				// Start searching for the last concurrent non-terminal
 				int j = i;
 				for (; j < childWord.length(); ++j)
-					if (!nonTerminalSymbols.contains(childWord[j]))
+					if (!symbols.is_non_terminal(childWord[j]))
 						break;
 
 				// If the whole childWord has non terminals
@@ -316,6 +337,85 @@ namespace Grammars {
 
 	} // of function check_non_terminal_symbols
 
+//----------------------------------------------------------------
+
+	// Check if the symbols of the child generate words of the length of the word
+	//
+	// Every symbol generates words with a length between its least and its
+	// greatest yield (1 for the terminal symbols), so the child can only
+	// generate the word if the length of the word is between the sums of them
+	//
+	// Inputs:
+	//		- const std::string& word: the word we want to generate
+	//		- std::string_view childWord: the word of the child to check
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//
+	// Outputs:
+	//		- bool true: the child needs pruning
+	//		- bool false: the child does NOT need pruning
+	//
+	bool check_yield_lengths(const std::string& word, std::string_view childWord,
+		const SymbolTable& symbols) {
+
+		size_t least = 0;
+		size_t greatest = 0;
+		for (char ch : childWord) {
+
+			size_t minYield = symbols.min_yield(ch);
+			if (minYield == SymbolTable::unbounded) return true;
+			least += minYield;
+			if (least > word.length()) return true;
+
+			size_t maxYield = symbols.max_yield(ch);
+			greatest = maxYield == SymbolTable::unbounded || greatest == SymbolTable::unbounded
+				? SymbolTable::unbounded : greatest + maxYield;
+		}
+
+		return greatest < word.length();
+
+	} // of function check_yield_lengths
+
+//----------------------------------------------------------------
+
+	// Check if the child has more of any terminal symbol than the word
+	//
+	// Every symbol of the child generates at least its least count of every
+	// terminal symbol, so their sums must not go over the counts in the word.
+	// This catches the children whose terminal symbols are in the right order
+	// but too many, like the parentheses of S -> (S) or the operators of S -> S+S
+	// If no non-terminal symbol always generates a terminal symbol, the counts of
+	// the terminal symbols of the child are already checked by their order
+	//
+	// Inputs:
+	//		- const SearchTarget& target: the word we want to generate and its counts
+	//		- std::string_view childWord: the word of the child to check
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//
+	// Outputs:
+	//		- bool true: the child needs pruning
+	//		- bool false: the child does NOT need pruning
+	//
+	bool check_terminal_counts(const SearchTarget& target, std::string_view childWord,
+		const SymbolTable& symbols) {
+
+		if (!symbols.has_min_counts()) return false;
+
+		std::array<uint32_t, 256> counts;
+		std::fill(counts.begin(), counts.begin() + target.counts.size(), 0);
+
+		for (char ch : childWord) {
+			if (!symbols.has_min_counts(ch)) continue;
+			for (const auto& [terminal, count] : symbols.min_counts(ch)) {
+				counts[terminal] += count;
+				if (counts[terminal] > target.counts[terminal])
+					return true;
+			}
+		}
+
+		return false;
+
+	} // of function check_terminal_counts
+
 //----------------------------------------------------------------
 
 	// Check if a rule generated output with two or more non-terminals that are the same
@@ -333,7 +433,7 @@ namespace Grammars {
 	// The expression 1/rules_with_the_same_input^2 indicates that if we have
 	// 10 rules with the same input it will only reduce the degree of the tree by 1%
 	//
-	bool check_rule_generation(const std::string& word, const std::string& childWord) {
+	bool check_rule_generation(const std::string& word, std::string_view childWord) {
 
 
 
@@ -342,222 +442,742 @@ namespace Grammars {
 
 //----------------------------------------------------------------
 
-	// Prune the child if its word is already in the tree
-	// or there is no way we can find a solution throught it
+	// Prune the child if there is no way we can find a solution throught it
+	// (the words that are already in the tree are checked by the search, since
+	// every search keeps its own set of them)
 	//
 	// Inputs:
-	//		- TreeNode* child: the child to check
-	//		- const std::unordered_set<std::string>& wordSet: The words that
-	//			have been already generated
-	//		- const std::unordered_set<char>& terminalSymbols: The terminal symbols
-	//		- const std::unordered_set<char>& nonTerminalSymbols: The non-terminal symbols
+	//		- const SearchTarget& target: the word we want to generate
+	//		- std::string_view childWord: the word of the child to check
+	//		- const SymbolTable& symbols: The symbols of the grammar
+	//		- QueryStats* stats: where the rule that cut the child is counted (nullptr if not needed)
 	//
 	// Outputs:
 	//		- bool true: the child needs proning
 	//		- bool false: the child does NOT need proning
 	//
-	bool prune(std::string word, TreeNode* child,
-		const std::unordered_set<std::string>& wordSet,
-		const std::unordered_set<char>& terminalSymbols,
-		const std::unordered_set<char>& nonTerminalSymbols,
-		const size_t maxRuleGenLen) {
+	bool prune(const SearchTarget& target, std::string_view childWord,
+		const SymbolTable& symbols, const size_t maxRuleGenLen, QueryStats* stats) {
 
-		std::string childWord = child->word;
+		const std::string& word = target.word;
 
 		// The least length of a rule output is 1 so we can prune any childWord that has
-		// more symbols than word
-		if (childWord.length() > word.length()) return true;
-
-		// If 'wordSet' already contains the word that 'child' holds return true
-		if (wordSet.contains(childWord)) return true;
+		// more symbols than word or that cannot generate words of the length of the word
+		if (childWord.length() > word.length() || check_yield_lengths(word, childWord, symbols)) {
+			count_pruned(stats, PruneRule::length);
+			return true;
+		}
 
 		// Check if the terminal symbols are in the right order
-		if (check_terminal_symbols(word, childWord, terminalSymbols))
+		if (check_terminal_symbols(word, childWord, symbols)) {
+			count_pruned(stats, PruneRule::terminalOrder);
 			return true;
+		}
 
 		// Check if concurrent non-terminals have expanded to unnecessarily much
-		if (check_non_terminal_positions(word, childWord, nonTerminalSymbols))
+		if (check_non_terminal_positions(word, childWord, symbols)) {
+			count_pruned(stats, PruneRule::nonTerminalPositions);
 			return true;
+		}
+
+		// Check if the child has too many of a terminal symbol
+		// (the order of the terminal symbols can be right while their number is not)
+		if (check_terminal_counts(target, childWord, symbols)) {
+			count_pruned(stats, PruneRule::terminalCounts);
+			return true;
+		}
 
 		// Check if a rule has expanded unnecessarily much
-		if (check_rule_generation(word, childWord))
+		if (check_rule_generation(word, childWord)) {
+			count_pruned(stats, PruneRule::ruleGeneration);
 			return true;
+		}
 
 		return false;
 	}
 
 //----------------------------------------------------------------
 
-	// Generate words using all the compinations of the given 'rules'
+	// The state of the lazy expansion of one node
+	//
+	// The child is built in a single buffer from left to right. Every time a
+	// substitution is chosen the part of the child that is already fixed is checked
+	// against the final word, so a choice that cannot lead to a solution cuts all
+	// the combinations of the substitutions to its right at once
+	//
+	struct ChildExpansion {
+
+		// Start the expansion of a parent
+		ChildExpansion(const SearchTarget& t, std::string_view parent, const SymbolTable& s,
+			size_t maxLen, std::vector<std::string>& words, std::vector<uint16_t>* rules, QueryStats* st)
+			: target{ t }, word{ t.word }, parentWord{ parent }, symbols{ s }, maxRuleGenLen{ maxLen },
+			minLength(parent.length() + 1, 0),
+			tailStart(parent.length() + 1, static_cast<long long>(t.word.length())),
+			lastReplaced{ SIZE_MAX }, minYield{ 0 }, matched{ 0 }, inPrefix{ true },
+			childWords{ words }, nChildren{ 0 }, childRules{ rules }, stats{ st } {
+
+			// Only the counts of the terminal symbols of the grammar are used
+			std::fill(counts.begin(), counts.begin() + t.counts.size(), 0);
+		}
+
+		const SearchTarget& target;							// The word we want to generate
+		const std::string& word;
+		std::string_view parentWord;						// The word of the expanded node
+		const SymbolTable& symbols;
+		size_t maxRuleGenLen;
+
+		std::vector<size_t> minLength;		// [p] the least yield length of parentWord[p..]
+		std::vector<long long> tailStart;	// [p] the last position of 'word' where the terminals
+											// of parentWord[p..] can start in order
+		size_t lastReplaced;				// The position of the last symbol that is replaced
+
+		std::string child;		// The fixed part of the child
+		size_t minYield;		// The least yield length of 'child'
+		size_t matched;			// The symbols of 'word' used by the terminals of 'child'
+		bool inPrefix;			// If 'child' has only terminal symbols
+
+		std::vector<std::string>& childWords;
+		size_t nChildren;
+
+		std::vector<uint16_t>* childRules;	// Where the rules of the children go (nullptr if not needed)
+		std::vector<uint16_t> choices;		// The rules chosen for the fixed part of the child
+
+		QueryStats* stats;		// Where the cuts are counted (nullptr if not needed)
+
+		std::array<uint32_t, 256> counts;	// The least count of every terminal symbol in 'child'
+
+	}; // of struct ChildExpansion
+
+//----------------------------------------------------------------
+
+	// Add a symbol to the fixed part of the child
+	//
+	// Inputs:
+	//		- ChildExpansion& e: the state of the expansion
+	//		- char ch: the symbol
+	//
+	// Outputs:
+	//		- bool true: the child can still generate the word
+	//		- bool false: the child needs pruning
+	//
+	static bool push_symbol(ChildExpansion& e, char ch) {
+
+		e.child.push_back(ch);
+
+		// The symbol may need more of a terminal symbol than the word has
+		bool enough = true;
+		if (e.symbols.has_min_counts(ch))
+			for (const auto& [terminal, count] : e.symbols.min_counts(ch)) {
+				e.counts[terminal] += count;
+				enough = enough && e.counts[terminal] <= e.target.counts[terminal];
+			}
+
+		e.minYield = std::min(e.minYield + std::min(e.symbols.min_yield(ch), e.word.length() + 1),
+			e.word.length() + 1);
+		if (!enough) {
+			count_pruned(e.stats, PruneRule::terminalCounts);
+			return false;
+		}
+		if (e.minYield > e.word.length()) {
+			count_pruned(e.stats, PruneRule::length);
+			return false;
+		}
+
+		if (!e.symbols.is_terminal(ch)) {
+			e.inPrefix = false;
+			return true;
+		}
+
+		// The terminals before the first non-terminal must be the start of the word
+		// and the rest must be found in the word in the same order
+		if (e.inPrefix && e.word[e.child.length() - 1] != ch) {
+			count_pruned(e.stats, PruneRule::terminalOrder);
+			return false;
+		}
+		while (e.matched < e.word.length() && e.word[e.matched] != ch)
+			++e.matched;
+		if (e.matched == e.word.length()) {
+			count_pruned(e.stats, PruneRule::terminalOrder);
+			return false;
+		}
+		++e.matched;
+
+		return true;
+
+	} // of function push_symbol
+
+//----------------------------------------------------------------
+
+	// Remove the symbols of the fixed part of the child after 'length'
 	//
-	// We push_back to the vector 'words' only the generated words that all their
-	// non-terminal symbols from the parent have been replaced. This happens since 
-	// in the end all the non-terminal symbols will be replaced to reach the solution.
-	// So generating children that not all non-terminal from their parent has been replaced
-	// is unnecessary and it will add to the complexity of the whole program
+	// Inputs:
+	//		- ChildExpansion& e: the state of the expansion
+	//		- size_t length: the length the fixed part goes back to
 	//
+	// Outputs:
 	//
-	//								HOW THIS FUNCTION WORKS
-	//==================================================================================
-	// We have a word: a@a@a
-	// In this word all the non-terminal symbols are indicated by '@' for the example
-	// The size of the outer rules vector equals the number of '@'
-	// So if there is only one '@' left (we know it because rulesIndex == rules.size()-1)
-	// we replace it with the last set of rules
-	// If there are more that one '@' we generate words by replacing the first '@'
-	// and the function 'generate_words' is called with the new words and the rulesIndex
-	// increased by one to point in the next set of rules
-	//==================================================================================
+	static void pop_symbols(ChildExpansion& e, size_t length) {
+
+		for (size_t i = length; i < e.child.length(); ++i)
+			if (e.symbols.has_min_counts(e.child[i]))
+				for (const auto& [terminal, count] : e.symbols.min_counts(e.child[i]))
+					e.counts[terminal] -= count;
+		e.child.resize(length);
+
+	} // of function pop_symbols
+
+//----------------------------------------------------------------
+
+	// Choose the substitutions of the symbols of the parent from 'position'
+	// to its end and keep the children that survive the pruning
 	//
 	// Inputs:
-	//		- std::string word: the initial word to generate the new ones
-	//		- int location: Index to indicate where to start searching for the
-	//			non-terminal symbol and where the replacement will take place
-	//		- std::unordered_map<char, std::vector<std::string>>& ruleMap:
-	//			A map containing all the replacements
-	//		- lastRuleIndex: index of the last replacement to indicate when to stop generating
-	//		- std::vector<std::string>& words: a vector for all the generated words
-	//		- size_t& wordsIndex: index for the vector words
-	//
-	//	Outputs:
-	//
-	void generate_words(std::string word, int location,
-		std::unordered_map<char, std::vector<std::string>>& ruleMap,
-		int lastRuleIndex, std::vector<std::string>& words, size_t& wordsIndex) {
-
-		// Find the position of the next non-terminal symbol
-		for (int i = location; i < word.size(); ++i)
-			if (ruleMap.contains(word[i])) {
-				location = i;
-				break;
+	//		- ChildExpansion& e: the state of the expansion
+	//		- size_t position: the next symbol of the parent
+	//
+	// Outputs:
+	//
+	static void expand_from(ChildExpansion& e, size_t position) {
+
+		size_t childLength = e.child.length();
+		size_t minYield = e.minYield;
+		size_t matched = e.matched;
+		bool inPrefix = e.inPrefix;
+
+		auto undo = [&]() {
+			pop_symbols(e, childLength);
+			e.minYield = minYield;
+			e.matched = matched;
+			e.inPrefix = inPrefix;
+		};
+
+		// Copy the symbols that are not replaced
+		for (; position < e.parentWord.length(); ++position) {
+			if (position <= e.lastReplaced && e.symbols.has_rules(e.parentWord[position])) break;
+			if (!push_symbol(e, e.parentWord[position])) {
+				undo();
+				return;
 			}
+		}
 
-		// For every rule that applies to this non-terminal symbol
-		for (int i = 0; i < ruleMap[word[location]].size(); ++i) {
+		// Every chosen non-terminal has been replaced so the child is complete
+		if (position == e.parentWord.length()) {
+			bool pruned;
+			{
+				ScopedTimer timer{ e.stats && e.stats->timed ? &e.stats->pruningSeconds : nullptr };
+				pruned = prune(e.target, e.child, e.symbols, e.maxRuleGenLen, e.stats);
+			}
+			if (!pruned) {
+				if (e.nChildren == e.childWords.size())
+					e.childWords.emplace_back();
+				e.childWords[e.nChildren++].assign(e.child);
+				if (e.childRules)
+					e.childRules->insert(e.childRules->end(), e.choices.begin(), e.choices.end());
+			}
+			undo();
+			return;
+		}
 
-			// Copy the initial word
-			std::string newWord = word;
+		size_t partLength = e.child.length();
+		size_t partMinYield = e.minYield;
+		size_t partMatched = e.matched;
+		bool partInPrefix = e.inPrefix;
 
-			// And replace the non-terminal symbol with the std::string from the rule
-			newWord.replace(newWord.begin() + location,
-				newWord.begin() + location + 1, ruleMap[word[location]][i]);
+		const std::vector<std::string>& outputs = e.symbols.rules_of(e.parentWord[position]);
+		for (size_t r = 0; r < outputs.size(); ++r) {
 
-			// Push the new word to the vector
-			// if the last non-terminal symbol has been reached
-			if (location == lastRuleIndex)
-				words[wordsIndex++] = newWord;
-			else
-				// Generate words by changing the next non-terminal symbol
-				generate_words(newWord, location + ruleMap[word[location]][i].length(),
-					ruleMap, lastRuleIndex + ruleMap[word[location]][i].length() - 1,
-					words, wordsIndex);
+			const std::string& output = outputs[r];
+			bool feasible = true;
+			for (size_t i = 0; feasible && i < output.length(); ++i)
+				feasible = push_symbol(e, output[i]);
+
+			// The rest of the parent must fit after the fixed part
+			if (feasible && e.minYield + e.minLength[position + 1] > e.word.length()) {
+				count_pruned(e.stats, PruneRule::length);
+				feasible = false;
+			}
+			if (feasible && static_cast<long long>(e.matched) > e.tailStart[position + 1]) {
+				count_pruned(e.stats, PruneRule::terminalOrder);
+				feasible = false;
+			}
+
+			if (feasible) {
+				if (e.childRules) e.choices.push_back(static_cast<uint16_t>(r));
+				expand_from(e, position + 1);
+				if (e.childRules) e.choices.pop_back();
+			}
+
+			pop_symbols(e, partLength);
+			e.minYield = partMinYield;
+			e.matched = partMatched;
+			e.inPrefix = partInPrefix;
 		}
-	}
 
+		undo();
 
-	// Generate children by using the rules in the non-terminal symbols
+	} // of function expand_from
+
+//----------------------------------------------------------------
+
+	// Generate the words of the children that survive the pruning by replacing
+	// every non-terminal symbol of the node with one of its rules
+	//
+	// The combinations of the rules are enumerated lazily from left to right and
+	// are cut as soon as the fixed part of the child cannot generate the word, so
+	// only the children that survive are ever written
+	//
+	// With Expansion::leftmost only the first non-terminal is replaced, so every
+	// child has one rule more than its parent and its prefix of terminals is
+	// checked against the word right away
 	//
 	// Inputs:
 	//		- TreeNode* node: the node that will be expanded
-	//		- const std::unordered_map<char, std::vector<std::string>>& ruleMap: 
-	//			a hash table for the rules
-	//		- std::vector<TreeNode*>& children: the vector that the generated children
-	//			will be put to
-	//		- const std::unordered_set<char>& nonTermSymbols: the non-terminal symbols of the grammar
+	//		- const SearchTarget& target: the word we want to generate
+	//		- const SymbolTable& symbols: the symbols of the grammar with their rules
+	//		- const size_t maxRuleGenLen: the longest output of a rule
+	//		- Expansion expansion: which non-terminal symbols are replaced
+	//		- std::vector<std::string>& childWords: the vector that the words will be
+	//			put to (its strings are reused between the expansions)
+	//		- std::vector<uint16_t>* childRules: the vector that the rules of the
+	//			children are put to (nullptr if not needed)
+	//		- QueryStats* stats: where the cuts and, if it is timed, the times are
+	//			added (nullptr if not needed)
 	//
 	// Outputs:
+	//		- size_t: the number of words put to the front of 'childWords'
 	//
-	void generate_children(TreeNode* node,
-		std::unordered_map<char, std::vector<std::string>> ruleMap,
-		std::vector<TreeNode*>& children,
-		const std::unordered_set<char>& nonTermSymbols) {
-
-		// Fill the vector
-		std::string word = node->word;
-		int lastRulePos = -1;
-		unsigned long long generatedWordsSize = 0;
-		for (int i = 0; i < word.size(); ++i)
-			if (ruleMap.contains(word[i])) {
-				lastRulePos = i;
-				if (!generatedWordsSize)
-					generatedWordsSize = ruleMap[word[i]].size();
-				else
-					generatedWordsSize *= ruleMap[word[i]].size();
+	static size_t expand_node(TreeNode* node, const SearchTarget& target,
+		const SymbolTable& symbols, const size_t maxRuleGenLen,
+		Expansion expansion, std::vector<std::string>& childWords,
+		std::vector<uint16_t>* childRules, QueryStats* stats) {
+
+		const std::string& word = target.word;
+		std::string_view parentWord = node->word;
+
+		// The pruning of the complete children is timed on its own and
+		// taken out of the generation time
+		bool timed = stats && stats->timed;
+		double pruningBefore = timed ? stats->pruningSeconds : 0;
+		auto startTime = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+
+		ChildExpansion e{ target, parentWord, symbols, maxRuleGenLen, childWords, childRules, stats };
+
+		// Find the last symbol that will be replaced
+		for (size_t p = 0; p < parentWord.length(); ++p)
+			if (symbols.has_rules(parentWord[p])) {
+				e.lastReplaced = p;
+				if (expansion == Expansion::leftmost) break;
 			}
 
-		// If there are no non-terminal symbols
-		if (lastRulePos == -1) return;
-
-		// Generate all the new words
-		std::vector<std::string> words(generatedWordsSize);
-		//std::vector<std::vector<int>> rulesPos(generatedWordsSize);
-		size_t wordsIndex = 0;
-		generate_words(word, 0, ruleMap, lastRulePos, words, wordsIndex);
-
-		// Create children
-		children = std::vector<TreeNode*>(generatedWordsSize);
-		for (size_t i = 0; i < words.size(); ++i) {
-			unsigned int countNonTerms = 0;
-			for (char ch : words[i])
-				if (nonTermSymbols.contains(ch))
-					++countNonTerms;
-			children[i] = new TreeNode{ node, words[i], node->depth + 1, countNonTerms };
+		// If there are no non-terminal symbols there are no children
+		if (e.lastReplaced == SIZE_MAX) return 0;
+
+		// Every symbol generates at least its least yield and the terminals of
+		// the rest of the parent must be found at the end of the word in order
+		long long start = static_cast<long long>(word.length());
+		for (size_t p = parentWord.length(); p-- > 0;) {
+
+			char ch = parentWord[p];
+			if (symbols.is_terminal(ch)) {
+				do --start;
+				while (start >= 0 && word[start] != ch);
+			}
+
+			size_t least = std::min(symbols.min_yield(ch), word.length() + 1);
+			e.minLength[p] = std::min(e.minLength[p + 1] + least, word.length() + 1);
+			e.tailStart[p] = start;
 		}
 
+		e.child.reserve(word.length() + maxRuleGenLen);
+		expand_from(e, 0);
+
+		if (timed)
+			stats->generationSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count()
+				- (stats->pruningSeconds - pruningBefore);
+
+		return e.nChildren;
+
+	} // of function expand_node
+
+//----------------------------------------------------------------
+
+	// Generate the words of the children that survive the pruning (see expand_node)
+	//
+	// Inputs:
+	//		- TreeNode* node: the node that will be expanded
+	//		- const SearchTarget& target: the word we want to generate
+	//		- const SymbolTable& symbols: the symbols of the grammar with their rules
+	//		- const size_t maxRuleGenLen: the longest output of a rule
+	//		- Expansion expansion: which non-terminal symbols are replaced
+	//		- std::vector<std::string>& childWords: the vector that the words will be
+	//			put to (its strings are reused between the expansions)
+	//		- QueryStats* stats: where the cuts and the times are added (nullptr if not needed)
+	//
+	// Outputs:
+	//		- size_t: the number of words put to the front of 'childWords'
+	//
+	size_t generate_children(TreeNode* node, const SearchTarget& target,
+		const SymbolTable& symbols, const size_t maxRuleGenLen,
+		Expansion expansion, std::vector<std::string>& childWords,
+		QueryStats* stats) {
+
+		return expand_node(node, target, symbols, maxRuleGenLen, expansion, childWords, nullptr, stats);
+
+	} // of function generate_children
+
+//----------------------------------------------------------------
+
+	// Generate the words of the children and the rules that make them
+	//
+	// Inputs:
+	//		- the same as the function above and
+	//		- std::vector<uint16_t>& childRules: the vector that the rules are put to
+	//		- size_t& rulesPerChild: where the number of rules of every child is stored
+	//			(every replaced symbol of the node gets one)
+	//
+	// Outputs:
+	//		- size_t: the number of words put to the front of 'childWords'
+	//
+	size_t generate_children(TreeNode* node, const SearchTarget& target,
+		const SymbolTable& symbols, const size_t maxRuleGenLen,
+		Expansion expansion, std::vector<std::string>& childWords,
+		std::vector<uint16_t>& childRules, size_t& rulesPerChild,
+		QueryStats* stats) {
+
+		rulesPerChild = 0;
+		for (char ch : node->word)
+			if (symbols.has_rules(ch)) {
+				++rulesPerChild;
+				if (expansion == Expansion::leftmost) break;
+			}
+
+		childRules.clear();
+		return expand_node(node, target, symbols, maxRuleGenLen, expansion, childWords, &childRules, stats);
+
+	} // of function generate_children
+
+//----------------------------------------------------------------
+
+	// Create a child in the Arena of the query
+	//
+	// Inputs:
+	//		- TreeNode* parent: the node that was expanded
+	//		- std::string_view word: the word of the child
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//		- Arena& arena: the arena of the query that will hold the node and its word
+	//
+	// Outputs:
+	//		- TreeNode*: the new child
+	//
+	TreeNode* create_child(TreeNode* parent, std::string_view word,
+		const SymbolTable& symbols, Arena& arena) {
+
+		unsigned int countNonTerms = 0;
+		for (char ch : word)
+			if (symbols.is_non_terminal(ch))
+				++countNonTerms;
+
+		return arena.make<TreeNode>(parent, arena.store(word), parent->depth + 1, countNonTerms);
+
 	}
 
-	// Clear the tree to avoid memory leaks by deleting all the nodes
+//----------------------------------------------------------------
+
+	// Create a child in the Arena of the query that keeps its rules instead of its word
+	//
 	// Inputs:
-	//		- FrontierNode* head: The head of the frontier
+	//		- TreeNode* parent: the node that was expanded
+	//		- std::string_view word: the word of the child (only counted, not kept)
+	//		- const uint16_t* rules: the rules that made the child from its parent
+	//		- size_t nRules: the number of rules
+	//		- const SymbolTable& symbols: the symbols of the grammar
+	//		- Arena& arena: the arena of the query that will hold the node and its rules
+	//
 	// Outputs:
+	//		- TreeNode*: the new child
 	//
-	void clear_tree(FrontierNode* head)
-	{
-		FrontierNode* temp = head;
-		while (head) {
-			
-			delete head->n;
-			temp = head->next;
-			delete head;
-			head = temp;
+	TreeNode* create_child(TreeNode* parent, std::string_view word,
+		const uint16_t* rules, size_t nRules, const SymbolTable& symbols, Arena& arena) {
+
+		unsigned int countNonTerms = 0;
+		for (char ch : word)
+			if (symbols.is_non_terminal(ch))
+				++countNonTerms;
+
+		void* memory = arena.allocate(sizeof(TreeNode) + nRules * sizeof(uint16_t), alignof(TreeNode));
+		TreeNode* child = new (memory) TreeNode{ parent, std::string_view{}, parent->depth + 1, countNonTerms };
+		std::copy(rules, rules + nRules, reinterpret_cast<uint16_t*>(child + 1));
+		return child;
+
+	} // of function create_child
+
+//----------------------------------------------------------------
+
+	// Get the word of a node
+	//
+	// Inputs:
+	//		- const TreeNode* node: a node of the tree
+	//
+	// Outputs:
+	//		- std::string_view: its word (valid until the next call)
+	//
+	std::string_view WordRebuilder::word_of(const TreeNode* node) {
+
+		if (!node->word.empty()) {
+			last = node;
+			word.assign(node->word);
+			return word;
 		}
-	}
+
+		// Go up to the last node or to one that has its word
+		path.clear();
+		const TreeNode* from = node;
+		while (from != last && from->word.empty()) {
+			path.push_back(from);
+			from = from->parent;
+		}
+		if (from != last)
+			word.assign(from->word);
+
+		for (size_t i = path.size(); i-- > 0;)
+			apply(path[i], word);
+
+		last = node;
+		return word;
+
+	} // of function word_of
 
 //----------------------------------------------------------------
 
-	// Print the solution found to the screen
+	// Get the words from the initial symbol to a node by replaying its rules
+	//
+	// Inputs:
+	//		- const TreeNode* node: a node of the tree
+	//
+	// Outputs:
+	//		- std::vector<std::string>: the words from the root to the node
+	//
+	std::vector<std::string> WordRebuilder::derivation_of(const TreeNode* node) {
+
+		path.clear();
+		for (const TreeNode* p = node; p != nullptr; p = p->parent)
+			path.push_back(p);
+
+		std::vector<std::string> words;
+		std::string current;
+		for (size_t i = path.size(); i-- > 0;) {
+			if (path[i]->word.empty())
+				apply(path[i], current);
+			else
+				current.assign(path[i]->word);
+			words.push_back(current);
+		}
+		return words;
+
+	} // of function derivation_of
+
+//----------------------------------------------------------------
+
+	// Replace the symbols of a word with the rules of a node: every symbol
+	// that has rules (only the first one with Expansion::leftmost) takes the
+	// next rule, like generate_children replaced them
+	//
+	// Inputs:
+	//		- const TreeNode* node: a node of NodeEncoding::rules
+	//		- std::string& word: the word of its parent, changed to its own
+	//
+	// Outputs:
+	//
+	void WordRebuilder::apply(const TreeNode* node, std::string& word) {
+
+		const uint16_t* rules = applied_rules(node);
+		bool replacing = true;
+
+		buffer.clear();
+		for (char ch : word)
+			if (replacing && symbols.has_rules(ch)) {
+				buffer += symbols.rules_of(ch)[*rules++];
+				replacing = expansion == Expansion::allNonTerminals;
+			}
+			else
+				buffer.push_back(ch);
+
+		word.swap(buffer);
+
+	} // of function apply
+
+//----------------------------------------------------------------
+
+	// Count the least steps of the derivations of every non-terminal symbol
+	// for every yield length up to the length of the target
+	//
+	// The suffixes of the outputs of the rules share their counts the same
+	// way as in WordSampler: a suffix of length l gives j symbols to its first
+	// symbol and the rest to the suffix after it, and the steps of the parts
+	// are added (one symbol replaced in every step) or the greatest one is
+	// taken (every symbol replaced at once). A rule adds one step. Outputs of
+	// one non-terminal symbol keep the length, so every length is repeated
+	// until nothing changes
+	//
+	// Inputs:
+	//		- const SearchTarget& target: the word we want to generate
+	//		- const SymbolTable& symbols: the symbols of the grammar with their rules
+	//		- Expansion expansion: which non-terminal symbols a step replaces
+	//
+	// Outputs:
+	//
+	StepBounds::StepBounds(const SearchTarget& target, const SymbolTable& symbols, Expansion expansion)
+		: symbols{ symbols }, length{ target.word.length() }, expansion{ expansion } {
+
+		size_t nNonTerms = symbols.n_non_terminals();
+		size_t width = length + 1;
+
+		auto combine = [&](uint32_t a, uint32_t b) -> uint32_t {
+			if (a == none || b == none) return none;
+			return expansion == Expansion::leftmost ? a + b : std::max(a, b);
+		};
+
+		// The exact steps of the non-terminal symbols and of the suffixes of the outputs
+		std::vector<uint32_t> exact(nNonTerms * width, none);
+		std::vector<std::pair<char, size_t>> items;		// The symbol and the next item (SIZE_MAX for the last)
+		std::vector<size_t> firstItems;					// [rule] its first item
+		std::vector<size_t> ruleOwners;					// [rule] the id of its non-terminal symbol
+		for (size_t a = 0; a < nNonTerms; ++a)
+			for (const std::string& output : symbols.rules_of(symbols.non_terminal(a))) {
+				firstItems.push_back(items.size());
+				ruleOwners.push_back(a);
+				for (size_t i = 0; i < output.length(); ++i)
+					items.push_back({ output[i], i + 1 < output.length() ? items.size() + 1 : SIZE_MAX });
+			}
+		std::vector<uint32_t> itemSteps(items.size() * width, none);
+
+		auto steps_of = [&](char ch, size_t l) -> uint32_t {
+			if (symbols.is_terminal(ch)) return l == 1 ? 0 : none;
+			return symbols.is_non_terminal(ch) ? exact[symbols.id(ch) * width + l] : none;
+		};
+
+		for (size_t l = 1; l <= length; ++l) {
+
+			// The suffixes with two or more symbols only need shorter lengths
+			for (size_t t = 0; t < items.size(); ++t) {
+				if (items[t].second == SIZE_MAX) continue;
+				uint32_t best = none;
+				for (size_t j = 1; j < l; ++j)
+					best = std::min(best, combine(steps_of(items[t].first, j), itemSteps[items[t].second * width + l - j]));
+				itemSteps[t * width + l] = best;
+			}
+
+			bool changed = true;
+			while (changed) {
+				changed = false;
+				for (size_t r = 0; r < firstItems.size(); ++r) {
+					size_t t = firstItems[r];
+					uint32_t steps = items[t].second == SIZE_MAX ? steps_of(items[t].first, l) : itemSteps[t * width + l];
+					if (steps == none) continue;
+					uint32_t& least = exact[ruleOwners[r] * width + l];
+					if (steps + 1 < least) {
+						least = steps + 1;
+						changed = true;
+					}
+				}
+			}
+
+			// The last symbols of the outputs take the whole length
+			for (size_t t = 0; t < items.size(); ++t)
+				if (items[t].second == SIZE_MAX)
+					itemSteps[t * width + l] = steps_of(items[t].first, l);
+		}
+
+		// The least steps of the yields of at most every length
+		leastUpTo.assign(nNonTerms * width, none);
+		for (size_t a = 0; a < nNonTerms; ++a)
+			for (size_t l = 1; l <= length; ++l)
+				leastUpTo[a * width + l] = std::min(leastUpTo[a * width + l - 1], exact[a * width + l]);
+
+	} // of constructor StepBounds
+
+//----------------------------------------------------------------
+
+	// Get a lower bound of the steps that turn a word into the word of the target
+	//
+	// The terminal symbols of the word stay, so its non-terminal symbols share
+	// the rest of the length and every one of them gets at most what is left
+	// after the least yields of the others
+	//
+	// Inputs:
+	//		- std::string_view word: the word of a node
+	//
+	// Outputs:
+	//		- unsigned int: the lower bound of the steps
+	//
+	unsigned int StepBounds::estimate(std::string_view word) const {
+
+		size_t terminals = 0;
+		size_t leastYields = 0;
+		for (char ch : word)
+			if (symbols.is_non_terminal(ch))
+				leastYields += std::min(symbols.min_yield(ch), length + 1);
+			else
+				++terminals;
+		if (terminals + leastYields > length) return 0;
+
+		size_t left = length - terminals;
+		uint32_t bound = 0;
+		for (char ch : word) {
+			if (!symbols.is_non_terminal(ch)) continue;
+
+			// The symbols that cannot fit are pruned, so they need no bound
+			size_t most = left - (leastYields - std::min(symbols.min_yield(ch), length + 1));
+			uint32_t steps = leastUpTo[symbols.id(ch) * (length + 1) + most];
+			if (steps == none) continue;
+			bound = expansion == Expansion::leftmost ? bound + steps : std::max(bound, steps);
+		}
+		return bound;
+
+	} // of function estimate
+
+//----------------------------------------------------------------
+
+	// Collect the words from the root node to the node of the solution
 	//
 	// Inputs:
 	//		- TreeNode* solutionNode: the node that holds the solution
-	//		- const std::unordered_set<char>& nonTermSymbols: the non-terminal symbols
-	//			of the grammar
 	//
 	// Outputs:
-	//		
-	void show_solution(TreeNode* solutionNode, const std::unordered_set<char>& nonTermSymbols) {
+	//		- std::vector<std::string>: the words of the derivation starting from the initial symbol
+	//
+	std::vector<std::string> derivation_of(TreeNode* solutionNode) {
 
 		// A vector for the words generated to reach the solution
 		std::vector<std::string> words;
 
 		// Until we reach the root node fill 'words' with the words in the nodes
 		while (solutionNode != nullptr) {
-			//if (solutionNode->parent) {
-			//	std::string newWord;
-			//	for (char ch : solutionNode->parent->word) {
-			//		if(ch)
-			//	}
-			//}
-			//else
-			words.push_back(solutionNode->word);
+			words.push_back(std::string{ solutionNode->word });
 			solutionNode = solutionNode->parent;
 		}
 
-		// Print the words to the screen starting from the end of 'words' (the root node)
-		for (int i = words.size() - 1; i >= 0; --i)
-			if (i)
-				std::cout << words[i] << " ->\n";
+		std::reverse(words.begin(), words.end());
+		return words;
+	}
+
+//----------------------------------------------------------------
+
+	// Print the solution found to the screen
+	//
+	// Inputs:
+	//		- const std::vector<std::string>& derivation: the words from the initial symbol to the solution
+	//
+	// Outputs:
+	//		
+	void show_solution(const std::vector<std::string>& derivation) {
+
+		// Print the words to the screen starting from the root node
+		for (size_t i = 0; i < derivation.size(); ++i)
+			if (i + 1 < derivation.size())
+				std::cout << derivation[i] << " ->\n";
 			else
-				std::cout << words[i];
+				std::cout << derivation[i];
 	}
 
 //----------------------------------------------------------------
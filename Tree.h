@@ -6,14 +6,20 @@
 //----------------------------------------------------------------
 
 #include <iostream>
+#include <array>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <string_view>
 #include <unordered_set>
 #include <unordered_map>
 
 //----------------------------------------------------------------
 
 #include "Macros.h"
+#include "Arena.h"
+#include "Symbols.h"
+#include "Stats.h"
 
 //----------------------------------------------------------------
 
@@ -21,20 +27,64 @@ namespace Grammars {
 
 //----------------------------------------------------------------
 
+	// Which non-terminal symbols of a word are replaced when its node is expanded
+	enum class Expansion {
+		allNonTerminals,	// Every non-terminal symbol at once
+		leftmost			// Only the leftmost one (leftmost derivations)
+	};
+
+	// The order in which the tree search expands its nodes
+	enum class Ordering {
+		greedy,				// The fewest non-terminal symbols first, then the shallowest node
+		aStar,				// The least depth plus a lower bound of the steps left (finds a shortest derivation)
+		iterativeDeepening	// Depth-first passes under a growing bound of aStar (memory linear in the depth)
+	};
+
+	// What the nodes of the tree search keep
+	enum class NodeEncoding {
+		words,		// The word of every node
+		rules		// Only the rules that made every node from its parent (the words are rebuilt,
+					// at most 65536 rules for every symbol)
+	};
+
+//----------------------------------------------------------------
+
+	// The word a search wants to generate and what the pruning needs to know about it
+	// (computed once for every query)
+	struct SearchTarget {
+
+		SearchTarget(const std::string& w, const SymbolTable& symbols)
+			: word{ w }, counts{ symbols.terminal_counts(w) } {}
+
+		const std::string& word;		// The word we want to generate
+		std::vector<uint32_t> counts;	// How many times every terminal symbol (by id) is in 'word'
+
+	}; // of struct SearchTarget
+
+//----------------------------------------------------------------
+
+	// The nodes are created in the Arena of the query and never destroyed
+	// one by one, so they only hold trivially destructible members
+	//
+	// With NodeEncoding::rules a node has an empty word (no word of the tree
+	// is empty, the grammar has no empty rules) and the choices of the rules
+	// that made it from its parent follow it in the Arena: the index of the
+	// rule of every replaced symbol, from left to right (see applied_rules)
+	//
 	struct TreeNode {
 
 		// Default constructor
 		TreeNode() 
-			:parent{ nullptr }, word{ std::string() }, depth{ 0 }, heuristic{ 0 } {}
+			:parent{ nullptr }, word{}, depth{ 0 }, heuristic{ 0 } {}
 
 		// Constructor to initialize children
-		TreeNode(TreeNode* p, std::string w, unsigned int d, unsigned int h)
+		TreeNode(TreeNode* p, std::string_view w, unsigned int d, unsigned int h)
 			:parent{ p }, word{ w }, depth{ d }, heuristic{ h } {}
 
 		TreeNode* parent;		// The parent node
-		std::string word;		// The word on the current node
+		std::string_view word;	// The word on the current node (stored in the Arena)
 		unsigned int depth;		// The depth of the node in the tree
-		unsigned int heuristic;	// The heuristic score
+		unsigned int heuristic;	// The heuristic score (the lower bound of the steps left with Ordering::aStar)
 
 	}; // of struct TreeNode
 
@@ -50,6 +100,45 @@ namespace Grammars {
 
 	}; // of struct FrontierNode
 
+//----------------------------------------------------------------
+
+	// A frontier ordered by the heuristic score and then by the depth of the nodes
+	// (or by any other two keys that are small integers)
+	//
+	// The heuristic score and the depth are small integers, so every pair of them
+	// gets its own bucket and both push and pop take O(1) time (plus the scan
+	// over the empty buckets when the smallest bucket runs out)
+	// Nodes with the same score and depth are taken in LIFO order
+	//
+	class BucketFrontier {
+	public:
+
+		// Create an empty frontier
+		BucketFrontier() : minHeuristic{ 0 }, count{ 0 } {}
+
+		// Add a node to the bucket of its heuristic score and depth
+		void push(TreeNode* node) { push(node, node->heuristic, node->depth); }
+
+		// Add a node to the bucket of two keys (less is better for both)
+		void push(TreeNode* node, size_t primary, size_t secondary);
+
+		// Remove and return the node with the smallest score and depth (nullptr if empty)
+		TreeNode* pop();
+
+		// Get the number of nodes in the frontier
+		size_t size() const { return count; }
+
+	private:
+
+		// buckets[heuristic][depth] holds the nodes as a stack (or buckets[primary][secondary])
+		std::vector<std::vector<std::vector<TreeNode*>>> buckets;
+		std::vector<size_t> bucketCounts;	// The number of nodes for every heuristic score
+		std::vector<size_t> minDepths;		// The smallest depth that may be non-empty for every score
+		size_t minHeuristic;				// The smallest score that may be non-empty
+		size_t count;
+
+	}; // of class BucketFrontier
+
 //----------------------------------------------------------------
 
 	// Get the first node that is in the frontier to check
@@ -57,35 +146,121 @@ namespace Grammars {
 	TreeNode* get_front(FrontierNode** frontierHead, FrontierNode** frontierTail);
 
 	// Add the new child to the back of the frontier
-	void add_to_back(FrontierNode** frontierHead, FrontierNode** frontierTail, TreeNode* child);
-	
-	// Add the child in order in the frontier
-	void add_in_order(FrontierNode** frontierHead, FrontierNode** frontierTail, TreeNode* child);
-
-	// Prune any child that holds a word that is already on the tree
-	// or any child that holds a word that cannot generate the solution
-	bool prune(std::string finalWord, TreeNode* child,
-		const std::unordered_set<std::string>& wordSet,
-		const std::unordered_set<char>& terminalSymbols,
-		const std::unordered_set<char>& nonTerminalSymbols,
-		const size_t maxRuleGenLen);
-
-	// Generate new words using the provided rules
-	void generate_words(std::string word, int location,
-		std::unordered_map<char, std::vector<std::string>>& ruleMap,
-		int lastRuleIndex, std::vector<std::string>& words, size_t& wordsIndex);
-
-	// Generate children by applying the rules to theirs parent's word
-	void generate_children(TreeNode* node,
-		std::unordered_map<char, std::vector<std::string>> ruleMap,
-		std::vector<TreeNode*>& children,
-		const std::unordered_set<char>& nonTermSymbols);
-
-	// Clear the tree to avoid memory leaks
-	void clear_tree(FrontierNode* head);
-
-	// Print the solution to the screen
-	void show_solution(TreeNode* solutionNode, const std::unordered_set<char>& nonTermSymbols);
+	void add_to_back(FrontierNode** frontierHead, FrontierNode** frontierTail, TreeNode* child,
+		Arena& arena);
+
+	// Prune any child that holds a word that cannot generate the solution
+	// (and count the rule that cut it if 'stats' is given)
+	bool prune(const SearchTarget& target, std::string_view childWord,
+		const SymbolTable& symbols, const size_t maxRuleGenLen, QueryStats* stats = nullptr);
+
+	// Generate the words of the children by applying the rules to their parent's word
+	// and keep only the ones that survive the pruning
+	size_t generate_children(TreeNode* node, const SearchTarget& target,
+		const SymbolTable& symbols, const size_t maxRuleGenLen,
+		Expansion expansion, std::vector<std::string>& childWords,
+		QueryStats* stats = nullptr);
+
+	// Generate the children as above and put the rules of every child to
+	// 'childRules' ('rulesPerChild' of them for every child, one after the other)
+	size_t generate_children(TreeNode* node, const SearchTarget& target,
+		const SymbolTable& symbols, const size_t maxRuleGenLen,
+		Expansion expansion, std::vector<std::string>& childWords,
+		std::vector<uint16_t>& childRules, size_t& rulesPerChild,
+		QueryStats* stats = nullptr);
+
+	// Create a child node and its word in the Arena
+	TreeNode* create_child(TreeNode* parent, std::string_view word,
+		const SymbolTable& symbols, Arena& arena);
+
+	// Create a child node in the Arena that keeps the rules that made it
+	// instead of its word (NodeEncoding::rules)
+	TreeNode* create_child(TreeNode* parent, std::string_view word,
+		const uint16_t* rules, size_t nRules, const SymbolTable& symbols, Arena& arena);
+
+	// Get the rules that made a node of NodeEncoding::rules from its parent
+	inline const uint16_t* applied_rules(const TreeNode* node) {
+		return reinterpret_cast<const uint16_t*>(node + 1);
+	}
+
+//----------------------------------------------------------------
+
+	// Rebuilds the words of the nodes that keep their rules by replaying the
+	// rules from the closest node that has its word (the root at worst)
+	//
+	// The last word it rebuilt is kept, so a node whose parent was the last
+	// one only costs one step, which is what the best-first search mostly pops
+	//
+	class WordRebuilder {
+	public:
+
+		WordRebuilder(const SymbolTable& symbols, Expansion expansion)
+			: symbols{ symbols }, expansion{ expansion }, last{ nullptr } {}
+
+		// Get the word of a node (valid until the next call)
+		std::string_view word_of(const TreeNode* node);
+
+		// Get the words from the initial symbol to a node
+		std::vector<std::string> derivation_of(const TreeNode* node);
+
+	private:
+
+		// Replace the symbols of 'word' with the rules of a node
+		void apply(const TreeNode* node, std::string& word);
+
+		const SymbolTable& symbols;
+		Expansion expansion;
+
+		const TreeNode* last;		// The node of 'word'
+		std::string word;
+		std::string buffer;
+		std::vector<const TreeNode*> path;
+
+	}; // of class WordRebuilder
+
+//----------------------------------------------------------------
+
+	// The heuristic of the A* ordering: a lower bound of the steps that turn
+	// a word into the word of the target
+	//
+	// For every non-terminal symbol and every length up to the length of the
+	// target it keeps the least steps of a derivation of a word of that length:
+	// the number of rules when one symbol is replaced in every step and the
+	// height of the derivation tree when all of them are replaced at once. A
+	// node gets the bound of the longest yield each of its non-terminal symbols
+	// can still have, so the bound never overestimates and A* finds a shortest
+	// derivation. The tables take O(items * length^2) time once for every query
+	//
+	class StepBounds {
+	public:
+
+		// Count the least steps of every symbol for the lengths up to the target
+		StepBounds(const SearchTarget& target, const SymbolTable& symbols, Expansion expansion);
+
+		// Get the lower bound of the steps a word needs (0 for the target itself)
+		unsigned int estimate(std::string_view word) const;
+
+	private:
+
+		static constexpr uint32_t none = UINT32_MAX;	// No derivation of that length
+
+		const SymbolTable& symbols;
+		size_t length;			// The length of the target
+		Expansion expansion;
+
+		// [non-terminal id * (length + 1) + l] the least steps of the
+		// derivations of the symbol with a yield of at most l symbols
+		std::vector<uint32_t> leastUpTo;
+
+	}; // of class StepBounds
+
+//----------------------------------------------------------------
+
+	// Get the words from the initial symbol to the solution
+	std::vector<std::string> derivation_of(TreeNode* solutionNode);
+
+	// Print the words of a derivation to the screen
+	void show_solution(const std::vector<std::string>& derivation);
 
 //----------------------------------------------------------------
 
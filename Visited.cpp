@@ -0,0 +1,287 @@
+
+//----------------------------------------------------------------
+
+#include "Visited.h"
+
+//----------------------------------------------------------------
+
+#include <bit>
+#include <cstring>
+#include <algorithm>
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The first size of the table of fingerprints (a power of 2)
+	static constexpr size_t initialSlots = 64;
+
+	// The number of bits the Bloom filter sets for every word
+	static constexpr size_t bloomProbes = 3;
+
+//----------------------------------------------------------------
+
+	// Mix the bits of a number so that every bit of the input
+	// changes half of the bits of the output (splitmix64)
+	static uint64_t mix(uint64_t x) {
+
+		x ^= x >> 30;
+		x *= 0xBF58476D1CE4E5B9ULL;
+		x ^= x >> 27;
+		x *= 0x94D049BB133111EBULL;
+		x ^= x >> 31;
+		return x;
+
+	} // of function mix
+
+//----------------------------------------------------------------
+
+	// Create an empty set
+	//
+	// Inputs:
+	//		- Mode mode: how the words are kept
+	//		- size_t bloomBits: the size of the Bloom filter in bits (0 for none)
+	//
+	// Outputs:
+	//
+	VisitedSet::VisitedSet(Mode mode, size_t bloomBits)
+		: mode{ mode }, count{ 0 }, mask{ 0 }, bloomMask{ 0 } {
+
+		if (mode != Mode::exact) {
+			highs.assign(initialSlots, 0);
+			if (mode == Mode::fingerprint128)
+				lows.assign(initialSlots, 0);
+			mask = initialSlots - 1;
+		}
+
+		if (bloomBits) {
+			bloomBits = std::bit_ceil(std::max<size_t>(bloomBits, 64));
+			bloom.assign(bloomBits / 64, 0);
+			bloomMask = bloomBits - 1;
+		}
+	}
+
+//----------------------------------------------------------------
+
+	// Hash a word to two independent 64 bit numbers
+	//
+	// Inputs:
+	//		- std::string_view word: the word
+	//
+	// Outputs:
+	//		- Fingerprint: the fingerprint of the word (never all zero)
+	//
+	VisitedSet::Fingerprint VisitedSet::fingerprint_of(std::string_view word) {
+
+		uint64_t high = mix(0x9E3779B97F4A7C15ULL ^ word.length());
+		uint64_t low = mix(0xD6E8FEB86659FD93ULL + word.length());
+
+		size_t i = 0;
+		for (; i + 8 <= word.length(); i += 8) {
+			uint64_t chunk;
+			std::memcpy(&chunk, word.data() + i, 8);
+			high = mix(high ^ chunk);
+			low = mix(low + chunk * 0xFF51AFD7ED558CCDULL);
+		}
+		if (i < word.length()) {
+			uint64_t chunk = 0;
+			std::memcpy(&chunk, word.data() + i, word.length() - i);
+			high = mix(high ^ chunk);
+			low = mix(low + chunk * 0xFF51AFD7ED558CCDULL);
+		}
+
+		if (!high && !low) low = 1;
+		return { high, low };
+
+	} // of function fingerprint_of
+
+//----------------------------------------------------------------
+
+	// Find the slot that holds a fingerprint or the empty slot where it belongs
+	//
+	// Inputs:
+	//		- const Fingerprint& fp: the fingerprint
+	//
+	// Outputs:
+	//		- size_t: the slot
+	//
+	size_t VisitedSet::find_slot(const Fingerprint& fp) const {
+
+		size_t slot = (fp.high ^ fp.low) & mask;
+
+		if (mode == Mode::fingerprint64) {
+			while (highs[slot] && highs[slot] != fp.high)
+				slot = (slot + 1) & mask;
+		}
+		else {
+			while ((highs[slot] || lows[slot]) && (highs[slot] != fp.high || lows[slot] != fp.low))
+				slot = (slot + 1) & mask;
+		}
+
+		return slot;
+
+	} // of function find_slot
+
+//----------------------------------------------------------------
+
+	// Double the size of the table and put the fingerprints back
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//
+	void VisitedSet::grow() {
+
+		std::vector<uint64_t> oldHighs = std::move(highs);
+		std::vector<uint64_t> oldLows = std::move(lows);
+
+		highs.assign(oldHighs.size() * 2, 0);
+		if (mode == Mode::fingerprint128)
+			lows.assign(oldHighs.size() * 2, 0);
+		mask = highs.size() - 1;
+
+		for (size_t i = 0; i < oldHighs.size(); ++i) {
+
+			Fingerprint fp{ oldHighs[i], mode == Mode::fingerprint128 ? oldLows[i] : 0 };
+			if (!fp.high && !fp.low) continue;
+
+			size_t slot = find_slot(fp);
+			highs[slot] = fp.high;
+			if (mode == Mode::fingerprint128)
+				lows[slot] = fp.low;
+		}
+
+	} // of function grow
+
+//----------------------------------------------------------------
+
+	// Check the bits of the Bloom filter for a fingerprint
+	//
+	// Inputs:
+	//		- const Fingerprint& fp: the fingerprint
+	//
+	// Outputs:
+	//		- bool false: the fingerprint is surely not in the set
+	//		- bool true: the fingerprint may be in the set
+	//
+	bool VisitedSet::maybe_contains(const Fingerprint& fp) const {
+
+		if (bloom.empty()) return true;
+
+		uint64_t step = std::rotl(fp.high, 32) | 1;
+		for (size_t i = 0; i < bloomProbes; ++i) {
+			size_t bit = (fp.high + i * step) & bloomMask;
+			if (!(bloom[bit / 64] >> (bit % 64) & 1))
+				return false;
+		}
+		return true;
+
+	} // of function maybe_contains
+
+//----------------------------------------------------------------
+
+	// Check if a word is in the set
+	//
+	// Inputs:
+	//		- std::string_view word: the word to find
+	//
+	// Outputs:
+	//		- bool: if the word (or, with the fingerprint modes, a word with
+	//			the same fingerprint) is in the set
+	//
+	bool VisitedSet::contains(std::string_view word) const {
+
+		if (mode == Mode::exact)
+			return words.contains(word);
+
+		Fingerprint fp = fingerprint_of(word);
+		if (mode == Mode::fingerprint64) {
+			fp.high = fp.high ? fp.high : 1;
+			fp.low = 0;
+		}
+		if (!maybe_contains(fp)) return false;
+
+		size_t slot = find_slot(fp);
+		return highs[slot] || (mode == Mode::fingerprint128 && lows[slot]);
+
+	} // of function contains
+
+//----------------------------------------------------------------
+
+	// Add a word to the set
+	//
+	// Inputs:
+	//		- std::string_view word: the word to add (with Mode::exact it must outlive the set)
+	//
+	// Outputs:
+	//		- bool true: the word was added
+	//		- bool false: the word was already in the set
+	//
+	bool VisitedSet::insert(std::string_view word) {
+
+		if (mode == Mode::exact) {
+			bool added = words.insert(word).second;
+			count += added;
+			return added;
+		}
+
+		// Keep the table at most 3/4 full so the probes stay short
+		if ((count + 1) * 4 > highs.size() * 3)
+			grow();
+
+		Fingerprint fp = fingerprint_of(word);
+		if (mode == Mode::fingerprint64) {
+			fp.high = fp.high ? fp.high : 1;
+			fp.low = 0;
+		}
+
+		size_t slot = find_slot(fp);
+		if (highs[slot] || (mode == Mode::fingerprint128 && lows[slot]))
+			return false;
+
+		highs[slot] = fp.high;
+		if (mode == Mode::fingerprint128)
+			lows[slot] = fp.low;
+		++count;
+
+		if (!bloom.empty()) {
+			uint64_t step = std::rotl(fp.high, 32) | 1;
+			for (size_t i = 0; i < bloomProbes; ++i) {
+				size_t bit = (fp.high + i * step) & bloomMask;
+				bloom[bit / 64] |= uint64_t{ 1 } << (bit % 64);
+			}
+		}
+
+		return true;
+
+	} // of function insert
+
+//----------------------------------------------------------------
+
+	// Get the number of bytes the set uses
+	//
+	// Inputs:
+	//
+	// Outputs:
+	//		- size_t: the bytes of the table (or an estimate of the nodes and
+	//			the buckets of the hash set with Mode::exact) and the Bloom filter
+	//
+	size_t VisitedSet::bytes() const {
+
+		size_t total = bloom.size() * sizeof(uint64_t);
+
+		if (mode == Mode::exact)
+			return total + words.bucket_count() * sizeof(void*)
+				+ words.size() * (sizeof(std::string_view) + sizeof(void*) + sizeof(size_t));
+
+		return total + (highs.size() + lows.size()) * sizeof(uint64_t);
+
+	} // of function bytes
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------
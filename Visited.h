@@ -0,0 +1,105 @@
+
+//----------------------------------------------------------------
+
+#pragma once
+
+//----------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <unordered_set>
+
+//----------------------------------------------------------------
+
+#include "Macros.h"
+
+//----------------------------------------------------------------
+
+namespace Grammars {
+
+//----------------------------------------------------------------
+
+	// The words a search has already put in its tree
+	//
+	// Mode::exact keeps views of the words (so they must outlive the set) and
+	// never makes a mistake. The fingerprint modes keep only a 64 or 128 bit hash
+	// of every word in a flat table with open addressing, which takes 8 or 16
+	// bytes for every slot instead of a node of a hash set for every word
+	//
+	// Collision risk: two different words with the same fingerprint make the
+	// search think that the second word is already in the tree, so it is pruned
+	// and a word that can be generated may be rejected. With n words in the set
+	// the chance that this happens at all is about n^2 / 2^(bits + 1):
+	//		- 64 bits: about 3 in 10000 for 10^8 words
+	//		- 128 bits: about 1 in 10^22 for 10^8 words
+	// Mode::exact should be used when a wrong answer is never acceptable
+	//
+	// A Bloom filter can be put in front of the table, so that most words that
+	// are not in the set are answered without touching the table
+	//
+	class VisitedSet {
+	public:
+
+		// How the words are kept
+		enum class Mode {
+			exact,			// Views of the words in a hash set
+			fingerprint64,	// 64 bit fingerprints
+			fingerprint128	// 128 bit fingerprints
+		};
+
+		// Create an empty set with a Bloom filter of 'bloomBits' bits (0 for none)
+		VisitedSet(Mode mode = Mode::exact, size_t bloomBits = 0);
+
+		// Check if a word is in the set
+		bool contains(std::string_view word) const;
+
+		// Add a word to the set (false if it was already there)
+		bool insert(std::string_view word);
+
+		// Get the number of words in the set
+		size_t size() const { return count; }
+
+		// Get the number of bytes the set uses
+		size_t bytes() const;
+
+	private:
+
+		// A 128 bit fingerprint (0 in 'high' and 'low' marks an empty slot)
+		struct Fingerprint {
+			uint64_t high;
+			uint64_t low;
+		};
+
+		// Get the fingerprint of a word
+		static Fingerprint fingerprint_of(std::string_view word);
+
+		// Find the slot of a fingerprint or the empty slot where it belongs
+		size_t find_slot(const Fingerprint& fp) const;
+
+		// Double the size of the table
+		void grow();
+
+		// Check the Bloom filter for a fingerprint
+		bool maybe_contains(const Fingerprint& fp) const;
+
+		Mode mode;
+		size_t count;
+
+		std::unordered_set<std::string_view> words;		// Mode::exact
+
+		std::vector<uint64_t> highs;	// The slots of the table (Mode::fingerprint64 uses only 'highs')
+		std::vector<uint64_t> lows;
+		size_t mask;					// The size of the table - 1
+
+		std::vector<uint64_t> bloom;	// The bits of the Bloom filter
+		size_t bloomMask;
+
+	}; // of class VisitedSet
+
+//----------------------------------------------------------------
+
+} // of namespace Grammars
+
+//----------------------------------------------------------------